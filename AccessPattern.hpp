@@ -0,0 +1,24 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef ACCESSPATTERN_HPP_
+#define ACCESSPATTERN_HPP_
+
+// How a file is going to be read, for the readers to pass on to the
+// kernel (with posix_fadvise() or madvise()) so it can read ahead, or
+// not, to suit.
+enum class AccessPattern {
+  kNormal,      // nothing in particular; the kernel's default
+  kSequential,  // from start to end: read ahead further than usual
+  kRandom,      // at scattered offsets: don't read ahead at all
+};
+
+#endif  // ACCESSPATTERN_HPP_
@@ -0,0 +1,56 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <sys/mman.h>
+
+#include <cstdint>
+
+#include "AlignedAllocator.hpp"
+using namespace std;
+
+// helper functions
+
+// Returns bytes rounded up to a whole number of huge pages
+static size_t huge_length(size_t bytes) {
+  return (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+}
+
+void* allocate_huge(size_t bytes) {
+  size_t length = huge_length(bytes);
+  void* mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (mapping != MAP_FAILED) {
+    return mapping;
+  }
+
+  // no huge pages reserved: map a huge page more than needed, and trim
+  // it down to where huge pages line up, so the kernel can use
+  // transparent huge pages for all of it
+  mapping = mmap(nullptr, length + kHugePageSize, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw bad_alloc();
+  }
+  char* start = static_cast<char*>(mapping);
+  size_t head =
+      (kHugePageSize - reinterpret_cast<uintptr_t>(start) % kHugePageSize) %
+      kHugePageSize;
+  if (head > 0) {
+    munmap(start, head);
+  }
+  munmap(start + head + length, kHugePageSize - head);
+  madvise(start + head, length, MADV_HUGEPAGE);
+  return start + head;
+}
+
+void deallocate_huge(void* ptr, size_t bytes) noexcept {
+  munmap(ptr, huge_length(bytes));
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef ALIGNEDALLOCATOR_HPP_
+#define ALIGNEDALLOCATOR_HPP_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// The size of a huge page
+inline constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+// Maps at least bytes bytes of memory, aligned to kHugePageSize and
+// backed by huge pages: from the hugetlb pool if the system has
+// reserved any (MAP_HUGETLB), otherwise by asking for transparent huge
+// pages (MADV_HUGEPAGE), which the kernel uses if it can. Throws
+// std::bad_alloc if no memory could be mapped at all.
+void* allocate_huge(size_t bytes);
+
+// Unmaps memory returned by allocate_huge(bytes)
+void deallocate_huge(void* ptr, size_t bytes) noexcept;
+
+///////////////////////////////////////////////////////////////////////////////
+// An AlignedAllocator is an allocator for standard containers whose
+// memory starts at a multiple of an alignment chosen at runtime, such
+// as the page aligned buffers O_DIRECT reads need.
+//
+// It can also back allocations of a huge page or more with huge pages
+// (see allocate_huge()), so that scanning a buffer of many megabytes
+// takes a few TLB entries instead of thousands.
+//
+// The alignment is part of the allocator, and moves along with the
+// memory when a container is moved or swapped. With the default
+// alignment it allocates exactly like std::allocator.
+///////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class AlignedAllocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  // Constructor for an AlignedAllocator with the default alignment.
+  AlignedAllocator() noexcept
+      : alignment_(__STDCPP_DEFAULT_NEW_ALIGNMENT__), huge_pages_(false) {}
+
+  // Constructor for an AlignedAllocator.
+  //
+  // Arguments:
+  // - alignment: what the address of the memory is a multiple of.
+  //   Must be a power of two.
+  // - huge_pages: whether to back allocations of at least kHugePageSize
+  //   bytes with huge pages. Smaller ones are allocated as usual.
+  explicit AlignedAllocator(size_t alignment, bool huge_pages = false) noexcept
+      : alignment_(alignment), huge_pages_(huge_pages) {}
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U>& other) noexcept
+      : alignment_(other.alignment()), huge_pages_(other.huge_pages()) {}
+
+  T* allocate(size_t n) {
+    if (is_huge(n)) {
+      return static_cast<T*>(allocate_huge(n * sizeof(T)));
+    }
+    if (alignment_ <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T*>(
+        ::operator new(n * sizeof(T), std::align_val_t(alignment_)));
+  }
+
+  void deallocate(T* ptr, size_t n) noexcept {
+    if (is_huge(n)) {
+      deallocate_huge(ptr, n * sizeof(T));
+      return;
+    }
+    if (alignment_ <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      ::operator delete(ptr, n * sizeof(T));
+      return;
+    }
+    ::operator delete(ptr, n * sizeof(T), std::align_val_t(alignment_));
+  }
+
+  // Returns the alignment of the memory this allocates
+  size_t alignment() const { return alignment_; }
+
+  // Returns whether or not large allocations use huge pages
+  bool huge_pages() const { return huge_pages_; }
+
+  // Memory from one allocator can be freed by another if they
+  // allocate it the same way
+  template <typename U>
+  bool operator==(const AlignedAllocator<U>& other) const {
+    return alignment_ == other.alignment() &&
+           huge_pages_ == other.huge_pages();
+  }
+
+ private:
+  // Whether an allocation of n Ts is backed by huge pages
+  bool is_huge(size_t n) const {
+    return huge_pages_ && n * sizeof(T) >= kHugePageSize;
+  }
+
+  size_t alignment_;  // the alignment of all memory allocated
+  bool huge_pages_;   // whether large allocations use huge pages
+};
+
+#endif  // ALIGNEDALLOCATOR_HPP_
@@ -13,6 +13,7 @@
 #define BUFFER_CHECKER_HPP_
 
 #include <string>
+#include <string_view>
 
 #include "BufferedFileReader.hpp"
 
@@ -23,6 +24,10 @@ class BufferChecker {
   // Returns true if there is a detectable error
   // False if an error was not detected
   bool check_char_errors(char to_check, off_t file_offset) {
+    if (bf_.in_memory_) {
+      // a small file read whole: buffer_ holds all of it from offset 0
+      return bf_.buffer_.at(file_offset) != to_check;
+    }
     size_t index = file_offset % BufferedFileReader::BUF_SIZE;
     if (index == BufferedFileReader::BUF_SIZE - 1) {
       // give some flexibility on how the last character is handled
@@ -35,6 +40,10 @@ class BufferChecker {
   // Returns true if there is a detectable error
   // False if an error was not detected
   bool check_token_errors(const std::string& token, off_t file_offset) {
+    if (bf_.in_memory_) {
+      return std::string_view(bf_.buffer_.data() + file_offset,
+                              token.length()) != token;
+    }
     size_t end_index =
         (file_offset + token.length()) % BufferedFileReader::BUF_SIZE;
     size_t start_index = file_offset % BufferedFileReader::BUF_SIZE;
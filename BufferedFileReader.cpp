@@ -9,73 +9,302 @@
  * author.
  */
 
+#include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
 #include "BufferedFileReader.hpp"
+#include "OpenFileLimit.hpp"
 using namespace std;
 
+// helper functions
+
+// Writes all n bytes of data to fd. Returns n, or -1 on error
+static ssize_t write_all(int fd, const char* data, size_t n) {
+  size_t written = 0;
+  while (written < n) {
+    ssize_t result = write(fd, data + written, n - written);
+    if (result == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    written += result;
+  }
+  return static_cast<ssize_t>(n);
+}
+
+// The first bytes of every checkpoint() blob, with its version
+static constexpr string_view CHECKPOINT_MAGIC = "BFRC2";
+
+// What a checkpoint() saves to tell whether a file is still the same
+struct FileIdentity {
+  uint64_t device;
+  uint64_t inode;
+  int64_t size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+
+  bool operator==(const FileIdentity& other) const = default;
+};
+
+static FileIdentity identity_of(const struct stat& st) {
+  return FileIdentity{st.st_dev, st.st_ino, st.st_size, st.st_mtim.tv_sec,
+                      st.st_mtim.tv_nsec};
+}
+
+// Appends the bytes of value to blob
+template <typename T>
+static void put_bytes(string* blob, const T& value) {
+  blob->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Appends str to blob, after its length
+static void put_string(string* blob, string_view str) {
+  put_bytes(blob, static_cast<uint32_t>(str.length()));
+  blob->append(str);
+}
+
+// Takes the bytes of value off the front of blob.
+// Returns false if blob is too short
+template <typename T>
+static bool get_bytes(string_view* blob, T* value) {
+  if (blob->length() < sizeof(T)) {
+    return false;
+  }
+  memcpy(value, blob->data(), sizeof(T));
+  blob->remove_prefix(sizeof(T));
+  return true;
+}
+
+// Takes a string written by put_string() off the front of blob.
+// Returns false if blob is too short
+static bool get_string(string_view* blob, string* str) {
+  uint32_t length = 0;
+  if (!get_bytes(blob, &length) || blob->length() < length) {
+    return false;
+  }
+  str->assign(blob->data(), length);
+  blob->remove_prefix(length);
+  return true;
+}
+
+// Returns the posix_fadvise() advice for pattern
+static int to_advice(AccessPattern pattern) {
+  switch (pattern) {
+    case AccessPattern::kSequential:
+      return POSIX_FADV_SEQUENTIAL;
+    case AccessPattern::kRandom:
+      return POSIX_FADV_RANDOM;
+    default:
+      return POSIX_FADV_NORMAL;
+  }
+}
+
 BufferedFileReader::BufferedFileReader(const std::string& fname,
                                        const std::string& delims)
-    : buffer_{}, fd_(open(fname.c_str(), O_RDONLY)) {
+    : BufferedFileReader(fname, delims, make_delim_table(delims)) {}
+
+BufferedFileReader::BufferedFileReader(const std::string& fname,
+                                       const std::vector<std::string>& delims)
+    : BufferedFileReader(fname, "", DelimTable{}) {
+  matcher_ = make_unique<DelimiterMatcher>(delims);
+}
+
+BufferedFileReader::BufferedFileReader(int fd, const std::string& delims)
+    : BufferedFileReader(fd, "", delims, make_delim_table(delims)) {}
+
+BufferedFileReader::BufferedFileReader(const std::string& fname,
+                                       const std::string& delims,
+                                       Lazy lazy)
+    : BufferedFileReader(-1, "", delims, make_delim_table(delims)) {
+  this->limit_ = lazy.limit;
+  this->lazy_ = true;
+  open_file(fname);
+}
+
+BufferedFileReader::BufferedFileReader(const std::string& fname,
+                                       const std::string& delims,
+                                       Direct direct)
+    : BufferedFileReader(-1, "", delims, make_delim_table(delims)) {
+  this->direct_ = true;
+  this->fill_size_ = direct_buffer_size(direct.buffer_size);
+  this->buffer_ = decltype(this->buffer_)(
+      this->fill_size_,
+      AlignedAllocator<char>(DIRECT_ALIGN, direct.huge_pages));
+  open_file(fname);
+  if (this->fd_ >= 0) {
+    // the first read happens now, as in the other constructors
+    fill_buffer();
+  }
+}
+
+size_t BufferedFileReader::direct_buffer_size(size_t requested_size) {
+  // capped before rounding up, so huge sizes can't wrap around
+  size_t size = min(requested_size, MAX_DIRECT_SIZE) + DIRECT_ALIGN - 1;
+  return max(size - size % DIRECT_ALIGN, DIRECT_ALIGN);
+}
+
+BufferedFileReader::BufferedFileReader(const std::string& fname,
+                                       const std::string& delims,
+                                       const DelimTable& delim_table)
+    : BufferedFileReader(open(fname.c_str(), O_RDONLY),
+                         fname,
+                         delims,
+                         delim_table) {}
+
+BufferedFileReader::BufferedFileReader(int fd,
+                                       const std::string& fname,
+                                       const std::string& delims,
+                                       const DelimTable& delim_table)
+    : buffer_(BUF_SIZE),
+      fd_(fd),
+      fname_(fname),
+      delims_(delims),
+      delim_table_(delim_table) {
   // fd_ = open(fname.c_str(), O_RDONLY);
   if (fd_ == -1) {
     good_ = false;
     return;
   }
-  lseek(fd_, 0, SEEK_SET);
+  // pipes, sockets and terminals can't seek, so their offsets
+  // are counted from wherever the reader started reading
+  off_t start = lseek(fd_, 0, SEEK_CUR);
+  this->seekable_ = start != -1;
+  this->file_pos_ = this->seekable_ ? start : 0;
 
   this->good_ = true;
-  this->delims_ = delims;
   this->curr_length_ = 0;
   this->curr_index_ = 0;
   fill_buffer();
 }
 
-BufferedFileReader::~BufferedFileReader() {
-  if (this->fd_ >= 0) {
-    close(this->fd_);
-    this->good_ = false;
-    this->fd_ = -1;
-    this->curr_length_ = 0;
-    this->curr_index_ = 0;
+BufferedFileReader::BufferedFileReader(BufferedFileReader&& other) noexcept
+    : curr_length_(0), curr_index_(0), fd_(-1), good_(false) {
+  *this = std::move(other);
+}
+
+BufferedFileReader& BufferedFileReader::operator=(
+    BufferedFileReader&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  close_file();
+  curr_length_ = exchange(other.curr_length_, 0);
+  curr_index_ = exchange(other.curr_index_, 0);
+  buffer_ = std::move(other.buffer_);
+  fd_ = exchange(other.fd_, -1);
+  fname_ = std::move(other.fname_);
+  // the delimiters are copied, so other can still open_file()
+  delims_ = other.delims_;
+  delim_table_ = other.delim_table_;
+  good_ = exchange(other.good_, false);
+  file_pos_ = exchange(other.file_pos_, 0);
+  seekable_ = other.seekable_;
+  sniffed_ = other.sniffed_;
+  in_memory_ = exchange(other.in_memory_, false);
+  parked_ = exchange(other.parked_, false);
+  fill_size_ = other.fill_size_;
+  direct_ = other.direct_;
+  direct_fd_ = exchange(other.direct_fd_, false);
+  // like the delimiters, other stays lazy and in the same group
+  lazy_ = other.lazy_;
+  limit_ = other.limit_;
+  last_used_ = other.last_used_;
+  access_ = other.access_;
+  drop_behind_ = other.drop_behind_;
+  dropped_to_ = exchange(other.dropped_to_, 0);
+  if (limit_ != nullptr && fd_ >= 0) {
+    limit_->moved(&other, this);
   }
+  decoder_ = std::move(other.decoder_);
+  follow_ = exchange(other.follow_, false);
+  follow_timeout_ms_ = other.follow_timeout_ms_;
+  timed_out_ = exchange(other.timed_out_, false);
+  inotify_fd_ = exchange(other.inotify_fd_, -1);
+  matcher_ = std::move(other.matcher_);
+  match_state_ = exchange(other.match_state_, DelimiterMatcher::kStart);
+  buf_num = other.buf_num;
+  return *this;
+}
+
+BufferedFileReader::~BufferedFileReader() {
+  close_file();
 }
 
 void BufferedFileReader::open_file(const std::string& fname) {
-  if (this->fd_ >= 0) {
-    close(this->fd_);
-    this->fd_ = -1;
-  }
-  this->fd_ = open(fname.c_str(), O_RDONLY);
-  if (this->fd_ < 0) {
-    this->good_ = false;
-    return;
+  close_file();
+  this->fname_ = fname;
+  if (this->lazy_) {
+    // opened by the first fill_buffer()
+    this->parked_ = true;
+    this->seekable_ = true;
+  } else {
+    this->fd_ = open_fd(fname);
+    if (this->fd_ < 0) {
+      this->good_ = false;
+      return;
+    }
+    this->seekable_ = lseek(this->fd_, 0, SEEK_SET) != -1;
+    advise_fd();
   }
   this->good_ = true;
-  lseek(this->fd_, 0, SEEK_SET);
+  if (this->buffer_.size() < this->fill_size_) {
+    this->buffer_.resize(this->fill_size_);  // in case it was moved away
+  }
+  this->curr_length_ = 0;
+  this->curr_index_ = 0;
+  this->match_state_ = DelimiterMatcher::kStart;
+  this->file_pos_ = 0;
+  this->dropped_to_ = 0;
+  this->sniffed_ = false;
 }
 
 void BufferedFileReader::close_file() {
-  if (this->fd_ < -1) {
-    return;
+  if (this->drop_behind_ && this->fd_ >= 0 && this->decoder_ == nullptr &&
+      this->file_pos_ > this->dropped_to_) {
+    // drop what was read since the last drop too
+    posix_fadvise(this->fd_, this->dropped_to_,
+                  this->file_pos_ - this->dropped_to_, POSIX_FADV_DONTNEED);
+  }
+  // the decoder's thread reads fd_, so it has to stop first
+  this->decoder_.reset();
+  if (this->inotify_fd_ >= 0) {
+    close(this->inotify_fd_);
+    this->inotify_fd_ = -1;
+  }
+  if (this->is_open()) {
+    if (this->fd_ >= 0) {
+      close_fd();
+    }
+    this->good_ = false;
+    this->in_memory_ = false;
+    this->parked_ = false;
+    this->curr_length_ = 0;
+    this->curr_index_ = 0;
   }
-  BufferedFileReader::~BufferedFileReader();
 }
 
 char BufferedFileReader::get_char() {
-  if (this->fd_ == -1) {
+  if (!this->is_open()) {
     this->good_ = false;
     return EOF;
   }
-  if (this->fd_ >= 0) {
-    if (curr_index_ >= curr_length_) {
-      fill_buffer();
-      if (!good_) {
-        return EOF;
-      }
+  if (curr_index_ >= curr_length_) {
+    if (!refill()) {
+      return EOF;
     }
   }
   char result = buffer_.at(curr_index_++);  // buffer_[curr_index_];
@@ -99,62 +328,108 @@ char BufferedFileReader::get_char() {
 //   }
 //   return result;
 // }
-optional<string> BufferedFileReader::get_token() {
-  if (this->fd_ == -1) {
+bool BufferedFileReader::find_delim(bool line_mode, int* delim_length) {
+  if (matcher_ == nullptr) {
+    while (curr_index_ < curr_length_) {
+      char cha = buffer_[curr_index_];
+      if (is_delim(cha) || (line_mode ? cha == '\n' : cha == EOF)) {
+        *delim_length = 1;
+        return true;
+      }
+      curr_index_++;
+    }
+    return false;
+  }
+
+  // match_state_ carries a partly matched delimiter over from the
+  // previous buffer, so delimiters split between two reads are found
+  while (curr_index_ < curr_length_) {
+    char cha = buffer_[curr_index_];
+    match_state_ = matcher_->next(match_state_, cha);
+    int32_t length = matcher_->match_length(match_state_);
+    if (length > 0 || (line_mode ? cha == '\n' : cha == EOF)) {
+      *delim_length = length > 0 ? length : 1;
+      match_state_ = DelimiterMatcher::kStart;
+      return true;
+    }
+    curr_index_++;
+  }
+  return false;
+}
+
+template <typename String>
+bool BufferedFileReader::read_token(String& token) {
+  if (!this->is_open()) {
     this->good_ = false;
-    return nullopt;
+    return false;
   }
-  string token;  //= "";
+  off_t start = follow_ ? tell() : 0;
+  timed_out_ = false;
   while (good_) {
     if (curr_index_ >= curr_length_) {
-      fill_buffer();
-      if (curr_length_ == 0) {
-        good_ = false;
+      if (!refill()) {
         break;
       }
     }
-    char& cha = buffer_.at(curr_index_++);  //[curr_index_];
-    if (is_delim(cha) || cha == -1) {
+    // append the whole run of non-delimiters at once instead of
+    // growing the token one char at a time
+    size_t run_start = curr_index_;
+    int delim_length = 0;
+    bool found = find_delim(false, &delim_length);
+    token.append(buffer_.data() + run_start, curr_index_ - run_start);
+    if (found) {
+      curr_index_++;  // consume the delimiter
+      // the rest of a multi-char delimiter was appended before we knew
+      token.resize(token.size() - (delim_length - 1));
       break;
     }
-    token += cha;
   }
-  if (token.empty() && !good_) {
-    return nullopt;
+  if (timed_out_) {
+    // hold on to the partial token until the rest of it is written
+    token.clear();
+    seek(start);
+    good_ = true;
+    return false;
   }
-  return token;
+  return !(token.empty() && !good_);
 }
-optional<vector<string>> BufferedFileReader::get_line() {
-  if (fd_ == -1 || !good_) {
+
+template <typename Sink>
+bool BufferedFileReader::scan_line(Sink& sink) {
+  if (!is_open() || !good_) {
     good_ = false;
-    return nullopt;
+    return false;
   }
-  vector<string> line = {};
-  string token;  //= "";
   size_t totalRead = 0;
+  off_t start = follow_ ? tell() : 0;
+  timed_out_ = false;
 
   while (good_) {
     if (curr_index_ >= curr_length_) {
-      fill_buffer();
-      if (curr_length_ == 0) {
-        good_ = false;
+      if (!refill()) {
         break;
       }
     }
-    char cha = buffer_.at(curr_index_++);
+    size_t run_start = curr_index_;
+    int delim_length = 0;
+    bool found = find_delim(true, &delim_length);
+    sink.append(buffer_.data() + run_start, curr_index_ - run_start);
+    if (!found) {
+      continue;  // token straddles the buffer, keep reading
+    }
+    char cha = buffer_[curr_index_++];
+    sink.end_token(delim_length - 1);
+    totalRead++;
     if (cha == '\n') {
-      line.push_back(token);
-      totalRead++;
-      token = "";
       break;
     }
-    if (is_delim(cha)) {
-      line.push_back(token);
-      totalRead++;
-      token = "";
-    } else {
-      token += cha;
-    }
+  }
+  if (timed_out_) {
+    // hold on to the partial line until the rest of it is written
+    sink.discard();
+    seek(start);
+    good_ = true;
+    return false;
   }
   //   if (!token.empty()) {
   //     line.push_back(token);
@@ -163,32 +438,571 @@ optional<vector<string>> BufferedFileReader::get_line() {
   // if (totalRead == 0) {
   // return nullopt;
   //}
+  return true;
+}
+
+namespace {
+
+// Sink for scan_line that builds a vector of strings.
+template <typename Line>
+class TokenVectorSink {
+ public:
+  // tokens share the line's allocator so moving them in never copies
+  TokenVectorSink(Line& line) : line_(line), token_(line.get_allocator()) {}
+
+  void append(const char* data, size_t len) { token_.append(data, len); }
+
+  void end_token(size_t trim) {
+    token_.resize(token_.size() - trim);
+    line_.push_back(std::move(token_));
+    token_.clear();
+  }
+
+  void discard() {
+    line_.clear();
+    token_.clear();
+  }
+
+ private:
+  Line& line_;
+  typename Line::value_type token_;
+};
+
+// Sink for scan_line that packs token bytes into one contiguous arena
+// and records where each token starts and how long it is.
+class ArenaSink {
+ public:
+  ArenaSink(std::string& arena,
+            std::vector<uint32_t>& offsets,
+            std::vector<uint32_t>& lengths)
+      : arena_(arena),
+        offsets_(offsets),
+        lengths_(lengths),
+        start_(arena.size()),
+        num_tokens_(offsets.size()),
+        arena_size_(arena.size()) {}
+
+  void append(const char* data, size_t len) { arena_.append(data, len); }
+
+  void end_token(size_t trim) {
+    arena_.resize(arena_.size() - trim);
+    offsets_.push_back(static_cast<uint32_t>(start_));
+    lengths_.push_back(static_cast<uint32_t>(arena_.size() - start_));
+    start_ = arena_.size();
+  }
+
+  void discard() {
+    arena_.resize(arena_size_);
+    offsets_.resize(num_tokens_);
+    lengths_.resize(num_tokens_);
+  }
+
+ private:
+  std::string& arena_;
+  std::vector<uint32_t>& offsets_;
+  std::vector<uint32_t>& lengths_;
+  size_t start_;
+  size_t num_tokens_;  // tokens before this line, for discard()
+  size_t arena_size_;  // bytes before this line, for discard()
+};
+
+}  // namespace
+
+template <typename Line>
+bool BufferedFileReader::read_line(Line& line) {
+  TokenVectorSink<Line> sink(line);
+  return scan_line(sink);
+}
+
+bool BufferedFileReader::read_line(std::string& arena,
+                                   std::vector<uint32_t>& offsets,
+                                   std::vector<uint32_t>& lengths) {
+  ArenaSink sink(arena, offsets, lengths);
+  return scan_line(sink);
+}
+
+optional<string> BufferedFileReader::get_token() {
+  string token;  //= "";
+  if (!read_token(token)) {
+    return nullopt;
+  }
+  return token;
+}
+
+optional<pmr::string> BufferedFileReader::get_token(
+    pmr::memory_resource* resource) {
+  pmr::string token(resource);
+  if (!read_token(token)) {
+    return nullopt;
+  }
+  return token;
+}
+
+optional<vector<string>> BufferedFileReader::get_line() {
+  vector<string> line = {};
+  if (!read_line(line)) {
+    return nullopt;
+  }
   return line;
 }
 
-int BufferedFileReader::tell() const {
-  if (this->fd_ == -1) {
+optional<pmr::vector<pmr::string>> BufferedFileReader::get_line(
+    pmr::memory_resource* resource) {
+  pmr::vector<pmr::string> line(resource);
+  if (!read_line(line)) {
+    return nullopt;
+  }
+  return line;
+}
+
+off_t BufferedFileReader::tell() const {
+  if (!this->is_open()) {
     return -1;
   }
-  int pos = (int)lseek(this->fd_, 0, SEEK_CUR);
-  return pos - curr_length_ + curr_index_;
+  // file_pos_ is where the buffer ends in the file
+  return file_pos_ - static_cast<off_t>(curr_length_) +
+         static_cast<off_t>(curr_index_);
   // return curr_index_ + BUF_SIZE * (buf_num - 1);
 }
 
-void BufferedFileReader::rewind() {
-  if (this->fd_ == -1) {
+bool BufferedFileReader::rewind() {
+  if (!this->is_open()) {
     this->good_ = false;
-    return;
+    return false;
+  }
+  if (!this->seekable_) {
+    return false;
   }
   this->good_ = true;
+  this->match_state_ = DelimiterMatcher::kStart;
+  if (this->in_memory_) {
+    this->curr_index_ = 0;
+    this->good_ = this->curr_length_ > 0;
+    return true;
+  }
+  this->file_pos_ = 0;
+  if (this->parked_) {
+    // opened again by the next read, so it doesn't take up an fd now.
+    // (Compressed files are never parked, so there is no decoder)
+    this->curr_length_ = 0;
+    this->curr_index_ = 0;
+    return true;
+  }
   lseek(this->fd_, 0, SEEK_SET);
+  // a compressed file is decompressed again from the start
+  this->decoder_.reset();
+  this->sniffed_ = false;
+  fill_buffer();
+  return true;
+}
+
+bool BufferedFileReader::seek(off_t offset) {
+  if (!this->is_open()) {
+    return false;
+  }
+  this->match_state_ = DelimiterMatcher::kStart;
+  if (this->parked_ && !this->sniffed_ && offset == 0) {
+    // the start is where the next read sniffs the file anyway
+    return rewind();
+  }
+  if (!this->sniffed_) {
+    // find out whether the file is compressed before moving
+    fill_buffer();
+  }
+  off_t buffer_start = file_pos_ - static_cast<off_t>(curr_length_);
+  if (offset >= buffer_start && offset < file_pos_) {
+    curr_index_ = static_cast<size_t>(offset - buffer_start);
+    good_ = true;
+    return true;
+  }
+  if (this->in_memory_) {
+    // past the end of a file that is all in the buffer
+    if (offset < 0) {
+      return false;
+    }
+    curr_index_ = curr_length_;
+    good_ = true;
+    return true;
+  }
+  if (!this->seekable_ || this->decoder_ != nullptr || offset < 0) {
+    return false;
+  }
+  // past the end of the file is the end of the file, as it is above
+  struct stat st {};
+  int result = this->fd_ >= 0 ? fstat(this->fd_, &st)
+                              : stat(this->fname_.c_str(), &st);
+  if (result == 0 && S_ISREG(st.st_mode)) {
+    offset = min(offset, st.st_size);
+  }
+  if (this->parked_) {
+    // the file is opened again at file_pos_ by the next read, so it
+    // doesn't take up an fd (or evict another reader's) until then
+    this->file_pos_ = offset;
+    this->curr_length_ = 0;
+    this->curr_index_ = 0;
+    this->good_ = true;
+    return true;
+  }
+  // keep the buffer lined up with multiples of fill_size_ in the file,
+  // just as if the file had been read from the start
+  off_t aligned = offset - offset % static_cast<off_t>(fill_size_);
+  if (!this->parked_) {
+    lseek(this->fd_, aligned, SEEK_SET);
+  }
+  this->file_pos_ = aligned;
+  this->good_ = true;
   fill_buffer();
+  curr_index_ = min(curr_length_, static_cast<size_t>(offset - aligned));
+  return true;
+}
+
+optional<string> BufferedFileReader::checkpoint() const {
+  if (!this->is_open() || this->fname_.empty() || !this->seekable_) {
+    return nullopt;
+  }
+  struct stat st {};
+  int result = this->fd_ >= 0 ? fstat(this->fd_, &st)
+                              : stat(this->fname_.c_str(), &st);
+  if (result != 0) {
+    return nullopt;
+  }
+  // the full path, so the job can resume from another directory
+  unique_ptr<char, decltype(&free)> path(realpath(fname_.c_str(), nullptr),
+                                         &free);
+
+  string blob(CHECKPOINT_MAGIC);
+  put_bytes(&blob, static_cast<int64_t>(tell()));
+  put_bytes(&blob, identity_of(st));
+  put_bytes(&blob, static_cast<uint8_t>(this->decoder_ != nullptr));
+  put_bytes(&blob, static_cast<uint8_t>(this->matcher_ != nullptr));
+  if (this->matcher_ != nullptr) {
+    put_bytes(&blob, static_cast<uint32_t>(matcher_->delims().size()));
+    for (const string& delim : matcher_->delims()) {
+      put_string(&blob, delim);
+    }
+  } else {
+    put_string(&blob, this->delims_);
+  }
+  put_string(&blob, path != nullptr ? string_view(path.get()) : fname_);
+  return blob;
+}
+
+bool BufferedFileReader::resume(string_view blob) {
+  if (!blob.starts_with(CHECKPOINT_MAGIC)) {
+    return false;
+  }
+  blob.remove_prefix(CHECKPOINT_MAGIC.length());
+  int64_t offset = 0;
+  FileIdentity saved{};
+  uint8_t compressed = 0;
+  uint8_t multi = 0;
+  if (!get_bytes(&blob, &offset) || !get_bytes(&blob, &saved) ||
+      !get_bytes(&blob, &compressed) || !get_bytes(&blob, &multi)) {
+    return false;
+  }
+  vector<string> multi_delims;
+  string delims;
+  if (multi != 0) {
+    uint32_t count = 0;
+    if (!get_bytes(&blob, &count) || count > blob.length()) {
+      return false;
+    }
+    multi_delims.resize(count);
+    for (string& delim : multi_delims) {
+      if (!get_string(&blob, &delim)) {
+        return false;
+      }
+    }
+  } else if (!get_string(&blob, &delims)) {
+    return false;
+  }
+  string fname;
+  if (!get_string(&blob, &fname) || !blob.empty() || offset < 0) {
+    return false;
+  }
+  struct stat st {};
+  if (stat(fname.c_str(), &st) != 0 || !(identity_of(st) == saved)) {
+    return false;
+  }
+
+  if (multi != 0) {
+    this->matcher_ = make_unique<DelimiterMatcher>(multi_delims);
+    this->delims_.clear();
+    this->delim_table_ = DelimTable{};
+  } else {
+    this->matcher_.reset();
+    this->delims_ = delims;
+    this->delim_table_ = make_delim_table(delims);
+  }
+  open_file(fname);
+  if (!this->good_) {
+    return false;
+  }
+  if (compressed == 0) {
+    if (offset > 0 && saved.size > static_cast<int64_t>(SMALL_FILE_SIZE)) {
+      // it isn't compressed, so seek() doesn't need to read the start
+      // of the file to find out first
+      this->sniffed_ = true;
+    }
+    if (!seek(offset)) {
+      return false;
+    }
+  } else {
+    // a compressed file can only be read from the start
+    while (tell() < offset) {
+      string_view rest = peek_buffer();
+      if (rest.empty()) {
+        return false;
+      }
+      consume(min(rest.length(), static_cast<size_t>(offset - tell())));
+    }
+  }
+  return true;
 }
 
 bool BufferedFileReader::good() const {
   return good_;
 }
 
+bool BufferedFileReader::seekable() const {
+  return is_open() && seekable_ && decoder_ == nullptr;
+}
+
+bool BufferedFileReader::direct() const {
+  return direct_fd_;
+}
+
+void BufferedFileReader::set_follow(bool follow, int timeout_ms) {
+  if (follow && in_memory_) {
+    // a small file was read whole and closed; the next read opens it
+    // again to see what is written after the part already read
+    in_memory_ = false;
+    parked_ = true;
+  }
+  // a pipe has no size to watch, and read() already blocks on it
+  follow_ = follow && seekable_ && decoder_ == nullptr;
+  follow_timeout_ms_ = timeout_ms;
+  if (follow_ && is_open()) {
+    good_ = true;
+  }
+}
+
+bool BufferedFileReader::advise(AccessPattern pattern) {
+  access_ = pattern;
+  return fd_ >= 0 && posix_fadvise(fd_, 0, 0, to_advice(pattern)) == 0;
+}
+
+bool BufferedFileReader::will_need(off_t offset, off_t length) {
+  return fd_ >= 0 &&
+         posix_fadvise(fd_, offset, length, POSIX_FADV_WILLNEED) == 0;
+}
+
+bool BufferedFileReader::dont_need(off_t offset, off_t length) {
+  return fd_ >= 0 &&
+         posix_fadvise(fd_, offset, length, POSIX_FADV_DONTNEED) == 0;
+}
+
+void BufferedFileReader::set_drop_behind(bool drop) {
+  drop_behind_ = drop;
+}
+
+bool BufferedFileReader::refill() {
+  fill_buffer();
+  while (curr_index_ >= curr_length_ && follow_ && fd_ >= 0) {
+    if (!wait_for_data(file_pos_)) {
+      timed_out_ = true;
+      good_ = true;  // the file may still grow later
+      return false;
+    }
+    fill_buffer();
+  }
+  if (curr_index_ >= curr_length_) {
+    good_ = false;
+  }
+  return curr_index_ < curr_length_;
+}
+
+bool BufferedFileReader::wait_for_data(off_t pos) {
+  struct stat st {};
+  if (fstat(fd_, &st) == 0 && st.st_size > pos) {
+    return true;
+  }
+
+  if (inotify_fd_ == -1 && !fname_.empty()) {
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0 &&
+        inotify_add_watch(inotify_fd_, fname_.c_str(),
+                          IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE) < 0) {
+      close(inotify_fd_);
+      inotify_fd_ = -1;
+    }
+    // the file may have grown before the watch was added
+    if (fstat(fd_, &st) == 0 && st.st_size > pos) {
+      return true;
+    }
+  }
+
+  if (inotify_fd_ >= 0) {
+    struct pollfd pfd {
+      inotify_fd_, POLLIN, 0
+    };
+    int result = poll(&pfd, 1, follow_timeout_ms_);
+    if (result <= 0) {
+      return result < 0 && errno == EINTR;
+    }
+    // drain the events, we only care that something happened
+    array<char, 4096> events{};
+    while (read(inotify_fd_, events.data(), events.size()) > 0) {
+    }
+    return true;
+  }
+
+  // no inotify: poll the size of the file, backing off up to 100ms
+  int waited_ms = 0;
+  int delay_ms = 1;
+  while (follow_timeout_ms_ < 0 || waited_ms < follow_timeout_ms_) {
+    usleep(delay_ms * 1000);
+    waited_ms += delay_ms;
+    delay_ms = min(delay_ms * 2, 100);
+    if (fstat(fd_, &st) == 0 && st.st_size > pos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+string_view BufferedFileReader::peek_buffer() {
+  if (!is_open()) {
+    good_ = false;
+    return {};
+  }
+  if (curr_index_ >= curr_length_ && good_) {
+    refill();
+  }
+  return {buffer_.data() + curr_index_, curr_length_ - curr_index_};
+}
+
+void BufferedFileReader::consume(size_t n) {
+  curr_index_ += n;
+}
+
+ssize_t BufferedFileReader::copy_range_to(int out_fd,
+                                          off_t start,
+                                          size_t len) {
+  if (!is_open() || decoder_ != nullptr || start < 0) {
+    return -1;
+  }
+  if (in_memory_) {
+    // the whole file is in the buffer already
+    if (static_cast<size_t>(start) >= curr_length_) {
+      return 0;
+    }
+    size_t n = min(len, curr_length_ - static_cast<size_t>(start));
+    return write_all(out_fd, buffer_.data() + start, n);
+  }
+  if (!seekable_ || (parked_ && !unpark())) {
+    return -1;
+  }
+
+  size_t copied = 0;
+  bool same_kind = true;  // whether copy_file_range() can be used
+  while (copied < len) {
+    off_t offset = start + static_cast<off_t>(copied);
+    ssize_t result;
+    if (same_kind) {
+      result = copy_file_range(fd_, &offset, out_fd, nullptr, len - copied, 0);
+      if (result == -1 && errno != EINTR && errno != EIO &&
+          errno != ENOSPC) {
+        // e.g. out_fd is a pipe, a socket, or on another file system
+        same_kind = false;
+        continue;
+      }
+    } else {
+      result = sendfile(out_fd, fd_, &offset, len - copied);
+    }
+    if (result == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return copied > 0 ? static_cast<ssize_t>(copied) : -1;
+    }
+    if (result == 0) {
+      break;  // the end of the file
+    }
+    copied += result;
+  }
+  return static_cast<ssize_t>(copied);
+}
+
+ssize_t BufferedFileReader::forward_line_to(int out_fd) {
+  if (!is_open()) {
+    good_ = false;
+    return -1;
+  }
+  timed_out_ = false;
+  if (curr_index_ >= curr_length_ && !refill()) {
+    return 0;
+  }
+  match_state_ = DelimiterMatcher::kStart;
+
+  ssize_t total = 0;
+  const char* start = buffer_.data() + curr_index_;
+  size_t buffered = curr_length_ - curr_index_;
+  while (true) {
+    auto newline = static_cast<const char*>(memchr(start, '\n', buffered));
+    if (newline != nullptr) {
+      size_t n = newline - start + 1;
+      curr_index_ += n;
+      return write_all(out_fd, start, n) == -1 ? -1 : total + n;
+    }
+    if (!in_memory_ && decoder_ == nullptr && seekable_) {
+      break;  // the rest of the line can be copied from the file
+    }
+    // otherwise the rest can only be found by reading it
+    if (write_all(out_fd, start, buffered) == -1) {
+      return -1;
+    }
+    total += buffered;
+    curr_index_ = curr_length_;
+    if (!refill()) {
+      return total;
+    }
+    start = buffer_.data() + curr_index_;
+    buffered = curr_length_ - curr_index_;
+  }
+
+  if (parked_ && !unpark()) {
+    return -1;
+  }
+  // find where the line ends without reading it into the buffer
+  off_t end = file_pos_;
+  while (!find_line_end(end, &end)) {
+    if (end == -1) {
+      return -1;
+    }
+    if (!follow_) {
+      break;  // the last line has no '\n'
+    }
+    if (!wait_for_data(end)) {
+      timed_out_ = true;
+      return 0;  // hold on to the line until the rest of it is written
+    }
+  }
+  if (write_all(out_fd, start, buffered) == -1) {
+    return -1;
+  }
+  ssize_t copied = copy_range_to(out_fd, file_pos_, end - file_pos_);
+  if (copied == -1) {
+    return -1;
+  }
+  // carry on reading after what was copied
+  file_pos_ += copied;
+  lseek(fd_, file_pos_, SEEK_SET);
+  curr_length_ = 0;
+  curr_index_ = 0;
+  return static_cast<ssize_t>(buffered) + copied;
+}
+
 // void BufferedFileReader::fill_buffer() {
 //   if (this->fd_ == -1) {
 //     this->good_ = false;
@@ -208,37 +1022,67 @@ bool BufferedFileReader::good() const {
 //   buf_num++;
 // }
 
-bool BufferedFileReader::is_delim(char to_check) {
-  return delims_.find(to_check) != string::npos;
-}
-
 void BufferedFileReader::fill_buffer() {
+  if (in_memory_) {
+    // the whole file is already in the buffer
+    curr_index_ = curr_length_;
+    good_ = false;
+    return;
+  }
   curr_length_ = 0;
   ssize_t result = 0;
 
+  if (parked_ && !unpark()) {
+    good_ = false;
+    return;
+  }
   if (fd_ == -1) {
     good_ = false;
-    exit(EXIT_FAILURE);
+    return;
+  }
+  if (limit_ != nullptr) {
+    last_used_ = limit_->tick();
+  }
+  drop_behind(file_pos_);
+  if (direct_fd_) {
+    fill_direct();
+    return;
+  }
+  if (!sniffed_ && read_small_file()) {
+    return;
   }
 
   ssize_t bytesRead = 0;
-  while (static_cast<uint64_t>(bytesRead) < BUF_SIZE) {
-    result = read(fd_, buffer_.data() + bytesRead, BUF_SIZE - bytesRead);
+  while (static_cast<size_t>(bytesRead) < fill_size_) {
+    if (decoder_ != nullptr) {
+      result =
+          decoder_->read(buffer_.data() + bytesRead, fill_size_ - bytesRead);
+    } else {
+      result = read(fd_, buffer_.data() + bytesRead, fill_size_ - bytesRead);
+    }
     if (result == -1) {
       if (errno != EINTR) {
         good_ = false;
         return;
       }
-    } else if (result == 0) {
+      continue;
+    }
+    if (result == 0) {
       good_ = false;
       break;
     }
     bytesRead += result;
   }
-  curr_length_ = (int)bytesRead;
+
+  if (!sniffed_ && sniff(bytesRead)) {
+    fill_buffer();
+    return;
+  }
+  curr_length_ = static_cast<size_t>(bytesRead);
+  file_pos_ += bytesRead;
   curr_index_ = 0;
   // buf_num++;
-  if (static_cast<uint64_t>(curr_length_) < BUF_SIZE) {
+  if (curr_length_ < fill_size_) {
     good_ = false;
   }
 
@@ -249,3 +1093,193 @@ void BufferedFileReader::fill_buffer() {
     good_ = true;
   }
 }
+
+bool BufferedFileReader::read_small_file() {
+  struct stat st {};
+  // follow mode and files without a name need fd_ to stay open
+  if (fname_.empty() || follow_ || direct_ || !seekable_ ||
+      fstat(fd_, &st) != 0 ||
+      !S_ISREG(st.st_mode) || st.st_size < file_pos_ ||
+      static_cast<uint64_t>(st.st_size - file_pos_) > SMALL_FILE_SIZE) {
+    return false;
+  }
+  // ask for one byte more than is left, so that a short read
+  // shows the end of the file was reached (unless it just grew)
+  size_t size = static_cast<size_t>(st.st_size - file_pos_) + 1;
+  if (buffer_.size() < size) {
+    buffer_.resize(size);
+  }
+  ssize_t result;
+  do {
+    result = read(fd_, buffer_.data(), size);
+  } while (result == -1 && errno == EINTR);
+  if (result == -1) {
+    good_ = false;
+    return true;
+  }
+
+  if (sniff(result)) {
+    fill_buffer();
+    return true;
+  }
+  curr_length_ = static_cast<size_t>(result);
+  curr_index_ = 0;
+  file_pos_ += result;
+  good_ = result > 0;
+  if (static_cast<size_t>(result) < size) {
+    close_fd();
+    in_memory_ = true;
+  }
+  return true;
+}
+
+bool BufferedFileReader::sniff(size_t length) {
+  // the first bytes of the file say whether it is compressed.
+  // If so, they are handed to a decoder and read again decompressed
+  sniffed_ = true;
+  unique_ptr<Codec> codec =
+      Decoder::make_codec(string_view(buffer_.data(), length));
+  if (codec == nullptr) {
+    return false;
+  }
+  if (direct_fd_) {
+    // the decoder reads into buffers of its own, which aren't aligned,
+    // so from here on the file is read normally, after the first bytes
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT);
+    lseek(fd_, file_pos_ + static_cast<off_t>(length), SEEK_SET);
+    direct_fd_ = false;
+  }
+  decoder_ = make_unique<Decoder>(fd_, string(buffer_.data(), length),
+                                  std::move(codec));
+  follow_ = false;
+  return true;
+}
+
+void BufferedFileReader::park() {
+  close_fd();
+  parked_ = true;
+}
+
+bool BufferedFileReader::unpark() {
+  parked_ = false;
+  if (limit_ != nullptr) {
+    limit_->make_room(this);
+  }
+  fd_ = open_fd(fname_);
+  if (fd_ < 0) {
+    fd_ = -1;
+    return false;
+  }
+  seekable_ = lseek(fd_, file_pos_, SEEK_SET) != -1;
+  advise_fd();
+  if (limit_ != nullptr) {
+    limit_->opened(this);
+  }
+  return true;
+}
+
+void BufferedFileReader::close_fd() {
+  close(fd_);
+  fd_ = -1;
+  direct_fd_ = false;
+  if (limit_ != nullptr) {
+    limit_->closed(this);
+  }
+}
+
+void BufferedFileReader::advise_fd() {
+  // a new fd already has the default advice
+  if (access_ != AccessPattern::kNormal) {
+    posix_fadvise(fd_, 0, 0, to_advice(access_));
+  }
+}
+
+void BufferedFileReader::drop_behind(off_t offset) {
+  if (!drop_behind_ || decoder_ != nullptr) {
+    return;
+  }
+  off_t end = offset - offset % DROP_BEHIND_SIZE;
+  if (end > dropped_to_) {
+    posix_fadvise(fd_, dropped_to_, end - dropped_to_, POSIX_FADV_DONTNEED);
+  }
+  // after a seek backwards, this starts dropping again from there
+  dropped_to_ = end;
+}
+
+int BufferedFileReader::open_fd(const std::string& fname) {
+  direct_fd_ = false;
+  if (direct_) {
+    int fd = open(fname.c_str(), O_RDONLY | O_DIRECT);
+    if (fd >= 0) {
+      direct_fd_ = true;
+      return fd;
+    }
+    if (errno != EINVAL) {
+      return -1;
+    }
+    // e.g. tmpfs, which has no O_DIRECT
+  }
+  return open(fname.c_str(), O_RDONLY);
+}
+
+void BufferedFileReader::fill_direct() {
+  // O_DIRECT reads have to start at an aligned offset, so after an
+  // unaligned seek, or at the end of a file that has since grown, the
+  // bytes before file_pos_ are read again and skipped
+  off_t aligned = file_pos_ - file_pos_ % static_cast<off_t>(DIRECT_ALIGN);
+  size_t skip = static_cast<size_t>(file_pos_ - aligned);
+  ssize_t result;
+  do {
+    result = pread(fd_, buffer_.data(), fill_size_, aligned);
+  } while (result == -1 && errno == EINTR);
+  if (result == -1) {
+    good_ = false;
+    return;
+  }
+  if (!sniffed_ && sniff(result)) {
+    fill_buffer();
+    return;
+  }
+  if (result <= static_cast<ssize_t>(skip)) {
+    curr_index_ = 0;
+    good_ = false;
+    return;
+  }
+  curr_length_ = static_cast<size_t>(result);
+  curr_index_ = skip;
+  file_pos_ = aligned + result;
+  good_ = true;
+}
+
+bool BufferedFileReader::find_line_end(off_t offset, off_t* end) {
+  struct stat st {};
+  if (fstat(fd_, &st) != 0) {
+    *end = -1;
+    return false;
+  }
+  off_t page_size = sysconf(_SC_PAGESIZE);
+  while (offset < st.st_size) {
+    // the pages are mapped straight from the page cache, not copied
+    off_t map_start = offset - offset % page_size;
+    size_t map_length = min(FORWARD_SCAN_SIZE, st.st_size - map_start);
+    void* mapping =
+        mmap(nullptr, map_length, PROT_READ, MAP_PRIVATE, fd_, map_start);
+    if (mapping == MAP_FAILED) {
+      *end = -1;
+      return false;
+    }
+    const char* data = static_cast<const char*>(mapping);
+    size_t skip = offset - map_start;
+    auto newline = static_cast<const char*>(
+        memchr(data + skip, '\n', map_length - skip));
+    off_t found = newline == nullptr ? -1 : map_start + (newline - data) + 1;
+    munmap(mapping, map_length);
+    if (found != -1) {
+      *end = found;
+      return true;
+    }
+    offset = map_start + static_cast<off_t>(map_length);
+  }
+  *end = max(offset, st.st_size);
+  return false;
+}
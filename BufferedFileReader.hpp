@@ -12,20 +12,63 @@
 #ifndef BUFFEREDFILEREADER_HPP_
 #define BUFFEREDFILEREADER_HPP_
 
+#include <sys/types.h>
+
 #include <array>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "AccessPattern.hpp"
+#include "AlignedAllocator.hpp"
+#include "Decoder.hpp"
+#include "DelimiterMatcher.hpp"
+#include "Delims.hpp"
+
+class OpenFileLimit;
+
 ///////////////////////////////////////////////////////////////////////////////
 // A BufferedFileReader is a class for reading files.
 //
 // This class is a moderately complex wrapper around POSIX file I/O calls
 // with more functionality than SimpleFileReader. Reading from the file
 // is buffered to increase performance.
+//
+// Small regular files (up to SMALL_FILE_SIZE bytes) are read whole
+// with a single read() on the first fill, and their file descriptor is
+// closed straight away; every call after that is served from memory.
+//
+// Files compressed with gzip or zstd are detected by their first bytes
+// and decompressed as they are read, on a helper thread, so they read
+// exactly like the uncompressed file would. Offsets (tell(), seek())
+// are offsets in the decompressed contents.
 ///////////////////////////////////////////////////////////////////////////////
 class BufferedFileReader {
  public:
+  // Selects the lazy constructor below, e.g.
+  // BufferedFileReader(fname, " \n", BufferedFileReader::Lazy{&limit}).
+  struct Lazy {
+    // the group of readers this one shares a cap on open files with,
+    // or nullptr for no cap. Not owned; must outlive the reader.
+    OpenFileLimit* limit = nullptr;
+  };
+
+  // Selects the O_DIRECT constructor below, e.g.
+  // BufferedFileReader(fname, " \n", BufferedFileReader::Direct{}).
+  struct Direct {
+    // the size of the buffer, and of each read. Rounded up to a
+    // multiple of DIRECT_ALIGN, and cut down to at most MAX_DIRECT_SIZE
+    // (just under 2 GiB), the most a single read() returns on Linux.
+    size_t buffer_size = 1024 * 1024;
+    // whether to back the buffer with huge pages, if it is at least
+    // kHugePageSize (see AlignedAllocator)
+    bool huge_pages = false;
+  };
+
   // Constructor for a BufferedFileReader. Should open the
   // file and do whatever is necesary to "set-up" the object.
   // After construction, reading from the file should start
@@ -46,6 +89,96 @@ class BufferedFileReader {
   BufferedFileReader(const std::string& fname,
                      const std::string& delims = "\r\n\t ");
 
+  // Constructor for a BufferedFileReader that reads from a file
+  // descriptor that is already open, such as STDIN_FILENO, the read end
+  // of a pipe, or a socket. Reading starts wherever the descriptor is.
+  // Descriptors that can't seek are supported: tell() counts the bytes
+  // read since construction, and rewind() and seek() report failure.
+  //
+  // Arguments:
+  // - fd: the file descriptor to read from. The BufferedFileReader
+  //   takes ownership of it and closes it when done (dup() it first
+  //   to keep using it, e.g. for stdin).
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  BufferedFileReader(int fd, const std::string& delims = "\r\n\t ");
+
+  // Constructor for a BufferedFileReader whose delimiters are fixed
+  // at compile time, e.g. BufferedFileReader(fname, Delims<',', '\n'>{}).
+  // Behaves exactly like the constructor above, but the delimiter
+  // lookup table is built by the compiler.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: the set of delimiters used for reading tokens
+  template <char... Cs>
+  BufferedFileReader(const std::string& fname, Delims<Cs...> /* delims */)
+      : BufferedFileReader(fname,
+                           std::string{Cs...},
+                           Delims<Cs...>::kTable) {}
+
+  // Constructor for a BufferedFileReader whose delimiters are strings
+  // instead of single characters, e.g. {"\r\n", "||", "<SEP>"}.
+  // Behaves like the constructor taking a string of delimiters, except
+  // that a token ends wherever one of the delimiter strings ends,
+  // and the whole delimiter string is consumed along with the token.
+  // Delimiters are found even if they straddle two reads of the file.
+  // If several delimiters could match, the one that ends first wins
+  // (see DelimiterMatcher).
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: the delimiter strings used for reading tokens.
+  //   Single character delimiters can be mixed in as strings of length 1.
+  BufferedFileReader(const std::string& fname,
+                     const std::vector<std::string>& delims);
+
+  // Constructor for a BufferedFileReader that does not touch the file
+  // until it is first read from: the open() and the first read() happen
+  // then. So creating many readers up front (e.g. one per input of a
+  // merge) costs no system calls. Until then good() is true and tell()
+  // is 0; if the file can't be opened, that first read returns
+  // EOF/nullopt. open_file() on this reader is lazy as well.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  // - lazy: the OpenFileLimit of the group of readers this reader is in,
+  //   if any. While the group is at its limit, the file of the least
+  //   recently used reader is closed to open this one, and is opened
+  //   again from the same offset when that reader needs it.
+  BufferedFileReader(const std::string& fname,
+                     const std::string& delims,
+                     Lazy lazy);
+
+  // Constructor for a BufferedFileReader that reads around the page
+  // cache, with O_DIRECT, straight into a page aligned buffer. For a
+  // one-pass scan of a very large file this saves copying everything
+  // through the page cache and evicting other files' pages from it.
+  // Each read is a whole buffer long, so the buffer should be large.
+  // Reading, tokens and tell() behave exactly as for the other
+  // constructors; the unaligned tail of the file and unaligned seeks
+  // are taken care of. If the file system doesn't support O_DIRECT, or
+  // the file is compressed, the file is read normally (see direct()).
+  // open_file() on this reader opens files with O_DIRECT as well.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  // - direct: the size of the buffer, and whether to use huge pages
+  BufferedFileReader(const std::string& fname,
+                     const std::string& delims,
+                     Direct direct);
+
+  // Returns the size of buffer a Direct reader asking for
+  // requested_size bytes gets (see Direct::buffer_size).
+  //
+  // Arguments:
+  // - requested_size: the Direct::buffer_size asked for
+  static size_t direct_buffer_size(size_t requested_size);
+
   // Destructor for a BufferedFileReader. Should clean up
   // any allocated resources such as memory or open files.
   //
@@ -113,6 +246,22 @@ class BufferedFileReader {
   // - nullopt if alrady at EOF or if the file is not open.
   std::optional<std::string> get_token();
 
+  // Same as get_token(), but the token is allocated from the given
+  // memory resource instead of the global heap. Pairing this with a
+  // std::pmr::monotonic_buffer_resource lets a caller release every
+  // token of a batch at once by releasing the resource.
+  //
+  // Arguments:
+  // - resource: the memory resource the returned token allocates from.
+  //   BufferedFileReader does NOT take ownership of it, and it must
+  //   outlive the returned token.
+  //
+  // Returns:
+  // - the next token in the file,
+  // - nullopt if alrady at EOF or if the file is not open.
+  std::optional<std::pmr::string> get_token(
+      std::pmr::memory_resource* resource);
+
   // Reads tokens until a new line is encountered and returns
   // those tokens in an array.
   // If we are already at the EOF, then return nullptr.
@@ -148,6 +297,20 @@ class BufferedFileReader {
   //   not open, return nullopt
   std::optional<std::vector<std::string>> get_line();
 
+  // Same as get_line(), but the vector and every token in it are
+  // allocated from the given memory resource.
+  //
+  // Arguments:
+  // - resource: the memory resource the returned line allocates from.
+  //   BufferedFileReader does NOT take ownership of it, and it must
+  //   outlive the returned line.
+  //
+  // Returns:
+  // - the vector of tokens, as described for get_line()
+  // - nullopt if already at the end of the file or the file is not open
+  std::optional<std::pmr::vector<std::pmr::string>> get_line(
+      std::pmr::memory_resource* resource);
+
   // Returns the current position the user is in to the file.
   //
   // Arguments: None
@@ -158,14 +321,75 @@ class BufferedFileReader {
   //   the start of the file, returns 0. If the user has read 2
   //   characters, return 2. etc.).
   // - -1 if there is no open file
-  int tell() const;
+  off_t tell() const;
 
   // Resets the file to start reading from the beginning
   // of the file that is currently open.
+  // Does Nothing if there is no file open currently,
+  // or if the file can't seek (e.g. a pipe).
+  // A parked file (see the lazy constructor) stays closed until the
+  // next read.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - true if the reader is back at the beginning of the file
+  // - false if there is no file open or the file can't seek
+  bool rewind();
+
+  // Moves the reader to the specified offset from the start of the
+  // file, so that the next read starts there. If the offset is already
+  // in the buffer, no reading from the file is needed. Nor is it if
+  // the file is parked (see the lazy constructor): it is opened again
+  // at the offset by the next read. A lazy reader that hasn't read
+  // anything yet is the exception, unless the offset is 0: its file is
+  // opened and read first, to find out whether it is compressed.
   // Does Nothing if there is no file open currently.
   //
+  // Arguments:
+  // - offset: the offset to move to. Seeking past the end of
+  //   the file leaves the reader at the end of the file.
+  //
+  // Returns:
+  // - true if the reader was moved
+  // - false if there is no file open, the offset is negative, or the
+  //   file can't seek (or is compressed) and the offset is not in the
+  //   buffer
+  bool seek(off_t offset);
+
+  // Saves where the reader is, so that a job that is stopped part way
+  // through a file can later carry on from the same place with
+  // resume(), instead of starting again from the beginning. The blob
+  // holds the offset, the delimiters, the name of the file, and enough
+  // about the file (device, inode, size and modification time) to tell
+  // whether it is still the same file when resuming.
+  //
   // Arguments: None
-  void rewind();
+  //
+  // Returns:
+  // - the checkpoint, as a compact binary blob
+  // - nullopt if there is no file open, the file was opened from a file
+  //   descriptor rather than by name, or it can't seek (e.g. a pipe)
+  std::optional<std::string> checkpoint() const;
+
+  // Opens the file saved in a checkpoint() and moves the reader to
+  // where it was, with the same delimiters, as if everything before it
+  // had just been read. Whatever file the reader had open is closed.
+  // The other settings (lazy, O_DIRECT, hints) are this reader's own.
+  // Only one fill is needed, at the saved offset; a compressed file is
+  // decompressed again up to the offset, without it being returned.
+  //
+  // Arguments:
+  // - blob: a blob returned by checkpoint()
+  //
+  // Returns:
+  // - true if the reader is back where the checkpoint was taken
+  // - false if the blob is not a checkpoint, the file can't be opened,
+  //   or it has been replaced or changed since (its inode, size or
+  //   modification time differ). The reader is not changed if the
+  //   blob or the file is wrong, but may have no file open if
+  //   reopening failed.
+  bool resume(std::string_view blob);
 
   // Returns whether or not the file is available for reading
   // (e.g. if the file is open and not at the end of file)
@@ -181,42 +405,370 @@ class BufferedFileReader {
   // - true otherwise
   bool good() const;
 
+  // Returns whether or not the open file supports rewind() and seek().
+  // Regular files do; pipes, sockets and terminals don't. Compressed
+  // files only support rewind(), which starts decompressing again.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - true if there is a file open and it can seek
+  // - false otherwise
+  bool seekable() const;
+
+  // Returns whether or not the open file is being read with O_DIRECT,
+  // around the page cache.
+  //
+  // Arguments: None
+  bool direct() const;
+
+  // Turns follow mode (like "tail -f") on or off.
+  // In follow mode, reaching the end of the file does not end reading:
+  // get_char, get_token and get_line instead wait for the file to grow
+  // (woken up by inotify, or by checking the file size with a backoff
+  // if inotify is not available) and carry on from where they were.
+  // A token or line is only returned once its delimiter or newline has
+  // been written; if the wait times out first, nothing is read, the
+  // call returns EOF/nullopt, and the partial token or line is read
+  // again by the next call. good() stays true while the file is open.
+  //
+  // Arguments:
+  // - follow: whether to turn follow mode on
+  // - timeout_ms: how long to wait for the file to grow before a call
+  //   gives up and returns. -1 waits forever.
+  void set_follow(bool follow, int timeout_ms = -1);
+
+  // The next four functions pass hints about how the file will be read
+  // on to the kernel's page cache. None of them change what is read.
+  // Offsets in a compressed file are offsets in the compressed bytes.
+
+  // Tells the kernel how the file is going to be read. The pattern is
+  // kept, and given again for every file the reader opens after this
+  // one (including reopening a file parked by an OpenFileLimit).
+  //
+  // Arguments:
+  // - pattern: how the file is going to be read
+  //
+  // Returns:
+  // - true if the kernel was told
+  // - false if there is no file descriptor open to tell it about
+  //   (the pattern is still kept for the next file)
+  bool advise(AccessPattern pattern);
+
+  // Asks the kernel to start reading part of the file into the page
+  // cache now, without waiting for it, so that reading it later
+  // doesn't have to wait for the disk.
+  //
+  // Arguments:
+  // - offset: the offset of the start of the part
+  // - length: the length of the part, 0 for up to the end of the file
+  //
+  // Returns:
+  // - true if the kernel was asked
+  // - false if there is no file descriptor open, or the kernel refused
+  bool will_need(off_t offset, off_t length);
+
+  // Tells the kernel that part of the file won't be read again soon,
+  // so its pages can be dropped from the page cache.
+  //
+  // Arguments:
+  // - offset: the offset of the start of the part
+  // - length: the length of the part, 0 for up to the end of the file
+  //
+  // Returns:
+  // - true if the kernel was told
+  // - false if there is no file descriptor open, or the kernel refused
+  bool dont_need(off_t offset, off_t length);
+
+  // Turns drop-behind on or off. With it on, the reader tells the kernel
+  // it doesn't need the pages it has read past (see dont_need()) every
+  // DROP_BEHIND_SIZE bytes, and the rest when the file is closed. So a
+  // one-pass scan of a huge file doesn't push everything else out of the
+  // page cache. Like advise(), it carries over to the next file opened.
+  // Compressed files are not dropped.
+  //
+  // Arguments:
+  // - drop: whether to turn drop-behind on
+  void set_drop_behind(bool drop);
+
+  // The next two functions give direct access to the buffer, for code
+  // layered on top of the reader (such as a CSV parser) that wants to
+  // scan the raw bytes of the file itself instead of reading them
+  // through get_char/get_token/get_line.
+
+  // Returns the bytes that are in the buffer and have not been read yet,
+  // refilling the buffer first if all of it has been read.
+  // Nothing is marked as read; see consume().
+  // The view is only valid until the next call that reads from the file.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the unread bytes in the buffer. An empty view if already
+  //   at the end of the file or if there is no file open.
+  std::string_view peek_buffer();
+
+  // Marks the first n bytes of the view returned by peek_buffer()
+  // as read, as if they had been read with get_char().
+  //
+  // Arguments:
+  // - n: the number of bytes to mark as read. Must not be more than
+  //   the size of the view last returned by peek_buffer().
+  void consume(size_t n);
+
+  // The next two functions copy bytes of the file straight to another
+  // file descriptor inside the kernel (with copy_file_range(), or
+  // sendfile() if the two can't be copied between), without them being
+  // read into the buffer or a string. For example, to read the header
+  // of a record as tokens and then pass the rest of it on untouched.
+  // copy_range_to() can't copy from compressed files or pipes, and
+  // forward_line_to() passes their lines through the buffer instead.
+
+  // Copies part of the file to out_fd, at out_fd's current offset.
+  // Does not move the reader.
+  //
+  // Arguments:
+  // - out_fd: the file descriptor to copy to: a file, pipe or socket
+  // - start: the offset in the file of the first byte to copy
+  // - len: the number of bytes to copy
+  //
+  // Returns:
+  // - the number of bytes copied, fewer than len if the file ends first
+  // - -1 if nothing could be copied, there is no file open, or the
+  //   file is compressed or can't seek
+  ssize_t copy_range_to(int out_fd, off_t start, size_t len);
+
+  // Copies the rest of the current line, up to and including its '\n',
+  // to out_fd, and moves the reader to the start of the next line, as
+  // if the line had been read with get_line(). Only the part of the
+  // line already in the buffer is written from the buffer. To find the
+  // end of the rest, the file is scanned through mmap() rather than
+  // read. In follow mode, waits for the '\n' to be written, just as
+  // get_line() does.
+  //
+  // Arguments:
+  // - out_fd: the file descriptor to copy to: a file, pipe or socket
+  //
+  // Returns:
+  // - the number of bytes copied, including the '\n'
+  // - 0 if already at the end of the file (or a follow mode wait timed
+  //   out, in which case nothing is copied)
+  // - -1 if there is no file open, or copying failed
+  ssize_t forward_line_to(int out_fd);
+
+  // Move constructor and move assignment for a BufferedFileReader.
+  // The open file, the buffer and the position in the file are handed
+  // over without copying, so readers can be kept in containers,
+  // returned from functions and recycled (see ReaderPool).
+  // Afterwards other has no file open, and can only be reused
+  // after calling open_file(). Move assignment closes the file this
+  // reader had open first.
+  //
+  // Arguments:
+  // - other: the reader to move from
+  BufferedFileReader(BufferedFileReader&& other) noexcept;
+  BufferedFileReader& operator=(BufferedFileReader&& other) noexcept;
+
   // Ignore These
   // If you want to know more, this is disabling the
   // copy constructor and the assignment operator.
   // These will be covered later in the class
   BufferedFileReader(const BufferedFileReader& other) = delete;
   BufferedFileReader& operator=(const BufferedFileReader& other) = delete;
-  BufferedFileReader(const BufferedFileReader&& other) = delete;
-  BufferedFileReader& operator=(const BufferedFileReader&& other) = delete;
 
   // Ignore this
   // This is necessary for testing and will be talked about later in the course
   friend class BufferChecker;
+  friend class LineBatch;
+  friend class MultiFileReader;
+  friend class OpenFileLimit;
 
  private:
   // Constants
   static constexpr uint64_t BUF_SIZE = 1024;  // the size of the buffer.
+  static constexpr uint64_t SMALL_FILE_SIZE = 64 * 1024;  // the largest
+                                                          // file read whole
+  static constexpr off_t DROP_BEHIND_SIZE = 1024 * 1024;  // bytes dropped
+                                                          // at a time
+  static constexpr off_t FORWARD_SCAN_SIZE = 1024 * 1024;  // bytes mapped
+                                                           // at a time to
+                                                           // find a '\n'
+  static constexpr size_t DIRECT_ALIGN = 4096;  // what O_DIRECT buffers,
+                                                // offsets and reads
+                                                // are multiples of
+  static constexpr size_t MAX_DIRECT_SIZE = 0x7ffff000;  // the largest
+                                                         // Direct buffer
 
   // fields
-  int curr_length_;  // The current number of characters stored in the buffer
-                     // To understand the purpose of this, consider when
-                     // a file is less than BUF_SIZE in length.
+  size_t curr_length_;  // The current number of characters stored in the
+                        // buffer. To understand the purpose of this,
+                        // consider when a file is less than BUF_SIZE in
+                        // length.
 
-  int curr_index_;  // The current index we are in to the buffer.
-                    // necessary since we many not parse the entire
-                    // buffer in one function call.
+  size_t curr_index_;  // The current index we are in to the buffer.
+                       // necessary since we many not parse the entire
+                       // buffer in one function call.
 
-  std::array<char, BUF_SIZE> buffer_;  // The buffer we maintiain for reading
-                                       // from the file.
+  // The buffer we maintiain for reading from the file. At least
+  // fill_size_ long (longer if a small file was read whole), on the heap
+  // so that moving a reader is cheap, and page aligned for O_DIRECT
+  std::vector<char, AlignedAllocator<char>> buffer_;
+  size_t fill_size_ = BUF_SIZE;  // how much of the file a fill reads
 
   int fd_;              // The File Descriptor that we use to manage our file.
+  std::string fname_;   // the name of the file, for follow mode
   std::string delims_;  // the delimiters used for reading tokens
-  bool good_;           // Whether or not the reader is good to read
+  DelimTable delim_table_;  // delims_ as a lookup table, for is_delim
+  bool good_;               // Whether or not the reader is good to read
+  off_t file_pos_ = 0;      // The offset in the file just past the end
+                            // of the buffer; tell() is computed from it
+  bool seekable_ = true;    // Whether or not fd_ can seek
+  bool sniffed_ = false;    // whether the start of the file has been
+                            // checked for compression yet
+  bool in_memory_ = false;  // whether the whole file is in the buffer
+                            // and fd_ has already been closed
+  bool parked_ = false;     // whether fd_ is closed for now, to be opened
+                            // again from fname_ at file_pos_ by the
+                            // next fill_buffer() (see Lazy)
+  bool lazy_ = false;       // whether open_file() leaves the file parked
+  OpenFileLimit* limit_ = nullptr;  // the group's cap on open files
+  uint64_t last_used_ = 0;          // when fd_ was last read, for limit_
+
+  AccessPattern access_ = AccessPattern::kNormal;  // given to each fd_
+  bool drop_behind_ = false;  // whether drop-behind is on
+  bool direct_ = false;       // whether to open files with O_DIRECT
+  bool direct_fd_ = false;    // whether fd_ was opened with O_DIRECT
+  off_t dropped_to_ = 0;      // the offset drop-behind has dropped up to
+
+  // Decompresses the file if it is compressed, or nullptr if not
+  std::unique_ptr<Decoder> decoder_;
+
+  bool follow_ = false;         // whether follow mode is on
+  int follow_timeout_ms_ = -1;  // how long to wait in follow mode
+  bool timed_out_ = false;      // whether the last wait timed out
+  int inotify_fd_ = -1;         // inotify instance watching fname_
+
+  // The automaton for multi-char delimiters, or nullptr if the
+  // delimiters are single chars and delim_table_ is used instead.
+  std::unique_ptr<DelimiterMatcher> matcher_;
+  int32_t match_state_ = DelimiterMatcher::kStart;  // state of matcher_
+
+  // Constructors the public constructors delegate to, taking the
+  // delimiters both as a string and as an already built lookup table.
+  // The second one does the work, given an already open fd (or -1)
+  // and the name of the file if it has one.
+  BufferedFileReader(const std::string& fname,
+                     const std::string& delims,
+                     const DelimTable& delim_table);
+  BufferedFileReader(int fd,
+                     const std::string& fname,
+                     const std::string& delims,
+                     const DelimTable& delim_table);
+
+  // Advances curr_index_ to the end of the current token in the buffer:
+  // the char that completes a delimiter (when reading a line, a '\n'
+  // also counts). Returns true and sets delim_length to the length of
+  // that delimiter if one was found, or false if the buffer ran out
+  // first, leaving curr_index_ == curr_length_.
+  bool find_delim(bool line_mode, int* delim_length);
+
+  // Calls fill_buffer(). In follow mode, if the end of the file was
+  // reached, waits for more data first. Returns true if there are bytes
+  // in the buffer, false at the end of the file or if the wait timed out
+  // (which sets timed_out_).
+  bool refill();
+
+  // Waits for the file to grow past pos, for at most
+  // follow_timeout_ms_. Returns false if the wait timed out.
+  bool wait_for_data(off_t pos);
+
+  // Whether there is a file open, either through fd_, in memory,
+  // or parked until it is next read
+  bool is_open() const { return fd_ != -1 || in_memory_ || parked_; }
+
+  // Whether fd_ can be closed by park() and later reopened at file_pos_
+  bool can_park() const {
+    return fd_ >= 0 && !fname_.empty() && seekable_ && decoder_ == nullptr &&
+           !follow_;
+  }
+
+  // Closes fd_, keeping the buffer and offset, until fill_buffer()
+  // next needs the file. Called by limit_ to make room for another file.
+  void park();
+
+  // Opens a parked file again at file_pos_. Returns false if it can't
+  // be opened, which closes the file.
+  bool unpark();
+
+  // Opens fname with O_DIRECT if direct_ (falling back to a normal open
+  // if the file system refuses), setting direct_fd_. Returns the fd.
+  int open_fd(const std::string& fname);
+
+  // Closes fd_ and tells limit_
+  void close_fd();
+
+  // Looks for the first '\n' at or after offset in the file, mapping
+  // the file FORWARD_SCAN_SIZE bytes at a time. Returns true and sets
+  // end to the offset just past it if there is one, otherwise returns
+  // false and sets end to the size of the file, or to -1 on error.
+  bool find_line_end(off_t offset, off_t* end);
+
+  // fill_buffer() for a file opened with O_DIRECT. Reads fill_size_
+  // bytes from file_pos_ rounded down to DIRECT_ALIGN, and starts
+  // curr_index_ past the bytes before file_pos_.
+  void fill_direct();
+
+  // Gives access_ to the kernel for a newly opened fd_
+  void advise_fd();
+
+  // With drop-behind on, drops the pages of the file before offset
+  // (rounded down to DROP_BEHIND_SIZE) that haven't been dropped yet.
+  void drop_behind(off_t offset);
 
   // Suggested Helpers
+  // Reads the next bytes of the file into the buffer, from decoder_
+  // if the file is compressed. The first call checks whether it is.
+  // Once the whole file is in memory, there is nothing more to read.
   void fill_buffer();
-  bool is_delim(char to_check);
+
+  // Called by the first fill_buffer(). If the rest of the file is a
+  // small regular file, reads all of it into the buffer with one read(),
+  // closes fd_ if that reached the end, and returns true. Returns false
+  // without reading anything otherwise (e.g. a pipe, or a large file).
+  bool read_small_file();
+
+  // Checks the first length bytes in the buffer for compression. If the
+  // file is compressed, hands them to a new decoder_ and returns true.
+  bool sniff(size_t length);
+  bool is_delim(char to_check) const {
+    return delim_table_[static_cast<unsigned char>(to_check)];
+  }
+
+  // Shared bodies of the get_token() and get_line() overloads, written
+  // once for any string/vector type. read_token appends the next token
+  // to token, read_line appends the tokens of the next line to line.
+  // Both return false where the public functions return nullopt.
+  template <typename String>
+  bool read_token(String& token);
+  template <typename Line>
+  bool read_line(Line& line);
+
+  // Reads the next line like get_line(), but appends the bytes of each
+  // token to arena and records the token's offset into arena and its
+  // length. Used by LineBatch.
+  bool read_line(std::string& arena,
+                 std::vector<uint32_t>& offsets,
+                 std::vector<uint32_t>& lengths);
+
+  // Scans the next line, handing the bytes of each token to
+  // sink.append() (possibly in several pieces) and calling
+  // sink.end_token(trim) after each one, where the last trim bytes
+  // appended turned out to be part of a multi-char delimiter.
+  // sink.discard() drops everything given to the sink for this line,
+  // when a follow mode wait times out part way through it.
+  // Returns false at EOF.
+  template <typename Sink>
+  bool scan_line(Sink& sink);
   int buf_num = 0;
 };
 
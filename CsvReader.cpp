@@ -0,0 +1,167 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <bit>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "CsvReader.hpp"
+using namespace std;
+
+CsvReader::CsvReader(BufferedFileReader& reader, char separator, char quote)
+    : reader_(reader),
+      separator_(separator),
+      quote_(quote),
+      in_quotes_(false) {}
+
+size_t CsvReader::find_structural(const char* data, size_t len, size_t pos) {
+#ifdef __SSE2__
+  const __m128i quotes = _mm_set1_epi8(quote_);
+  const __m128i separators = _mm_set1_epi8(separator_);
+  const __m128i newlines = _mm_set1_epi8('\n');
+
+  for (; pos + 16 <= len; pos += 16) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    uint32_t quote_mask =
+        _mm_movemask_epi8(_mm_cmpeq_epi8(block, quotes));
+    uint32_t structural_mask = _mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(block, separators),
+                     _mm_cmpeq_epi8(block, newlines)));
+
+    // Prefix xor of the quote bits: bit i is set if an odd number of
+    // quotes come at or before i, i.e. i is inside quotes. A doubled
+    // quote flips twice, so escaped quotes need no special handling.
+    uint32_t inside = quote_mask;
+    inside ^= inside << 1;
+    inside ^= inside << 2;
+    inside ^= inside << 4;
+    inside ^= inside << 8;
+    if (in_quotes_) {
+      inside = ~inside;
+    }
+    inside &= 0xFFFF;
+
+    uint32_t outside = structural_mask & ~inside;
+    if (outside != 0) {
+      in_quotes_ = false;
+      return pos + countr_zero(outside);
+    }
+    in_quotes_ = (inside >> 15) & 1;
+  }
+#endif
+
+  for (; pos < len; pos++) {
+    char c = data[pos];
+    if (c == quote_) {
+      in_quotes_ = !in_quotes_;
+    } else if (!in_quotes_ && (c == separator_ || c == '\n')) {
+      return pos;
+    }
+  }
+  return len;
+}
+
+string_view CsvReader::make_field(const char* data, size_t len) {
+  if (len == 0 || data[0] != quote_) {
+    return {data, len};
+  }
+  // strip the quotes (a missing closing quote is tolerated)
+  data++;
+  len--;
+  if (len > 0 && data[len - 1] == quote_) {
+    len--;
+  }
+  if (memchr(data, quote_, len) == nullptr) {
+    return {data, len};
+  }
+
+  // unescaped_ has room for the whole record,
+  // so appending never moves earlier fields
+  size_t start = unescaped_.size();
+  for (size_t i = 0; i < len; i++) {
+    unescaped_ += data[i];
+    if (data[i] == quote_ && i + 1 < len && data[i + 1] == quote_) {
+      i++;
+    }
+  }
+  return {unescaped_.data() + start, unescaped_.size() - start};
+}
+
+optional<span<const string_view>> CsvReader::get_record() {
+  record_.clear();
+  unescaped_.clear();
+  bounds_.clear();
+  fields_.clear();
+  in_quotes_ = false;
+
+  const char* base = nullptr;  // where the bytes of the record are
+  size_t length = 0;           // the number of bytes of the record so far
+  size_t field_start = 0;
+  bool complete = false;
+
+  while (!complete) {
+    string_view view = reader_.peek_buffer();
+    if (view.empty()) {
+      break;  // EOF
+    }
+
+    size_t used = view.size();
+    size_t pos = 0;
+    while (pos < view.size()) {
+      size_t end = find_structural(view.data(), view.size(), pos);
+      if (end == view.size()) {
+        break;
+      }
+      bounds_.emplace_back(field_start, length + end);
+      field_start = length + end + 1;
+      pos = end + 1;
+      if (view[end] == '\n') {
+        complete = true;
+        used = pos;
+        break;
+      }
+    }
+
+    if (complete && length == 0) {
+      base = view.data();  // the whole record is in the buffer, no copy
+    } else {
+      record_.append(view.data(), used);
+    }
+    length += used;
+    reader_.consume(used);
+  }
+
+  if (length == 0) {
+    return nullopt;
+  }
+  if (!complete) {
+    bounds_.emplace_back(field_start, length);  // no newline at EOF
+  }
+  if (base == nullptr) {
+    base = record_.data();
+  }
+
+  // accept "\r\n" line endings
+  pair<size_t, size_t>& last = bounds_.back();
+  if (complete && last.second > last.first && base[last.second - 1] == '\r') {
+    last.second--;
+  }
+
+  unescaped_.reserve(length);
+  for (const auto& [start, end] : bounds_) {
+    fields_.push_back(make_field(base + start, end - start));
+  }
+  return span<const string_view>(fields_);
+}
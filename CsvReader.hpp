@@ -0,0 +1,107 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef CSVREADER_HPP_
+#define CSVREADER_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "BufferedFileReader.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// A CsvReader reads quote-aware CSV (or TSV) records from a
+// BufferedFileReader.
+//
+// Unlike splitting get_line() on delimiters, a field can be quoted
+// ("a,b"), in which case separators and newlines inside the quotes are
+// part of the field, and a doubled quote ("say ""hi""") stands for a
+// single quote char. Records end at an unquoted '\n' (a "\r\n" ending
+// is accepted too). The surrounding quotes are not part of the field.
+//
+// Fields are returned as views. Wherever possible they point straight
+// into the reader's buffer; a record is only copied if it straddles
+// a buffer refill, and a field only if it contains escaped quotes.
+// Quotes, separators and newlines are found 16 bytes at a time with
+// SSE2 when it is available, in the style of simdcsv.
+///////////////////////////////////////////////////////////////////////////////
+class CsvReader {
+ public:
+  // Constructor for a CsvReader.
+  //
+  // Arguments:
+  // - reader: the reader to read records from. The reader should not
+  //   be used for anything else while the CsvReader reads from it.
+  //   CsvReader does NOT take ownership of the reader, and the reader
+  //   must outlive the CsvReader.
+  // - separator: the char between two fields, e.g. ',' or '\t'
+  // - quote: the char used to quote a field
+  CsvReader(BufferedFileReader& reader, char separator = ',', char quote = '"');
+
+  // Reads the next record.
+  //
+  // For example, if the file had the contents
+  //////////////////////////////////////////////////////////
+  // id,name,comment
+  // 1,"Smith, John","said ""hi""
+  // twice"
+  //////////////////////////////////////////////////////////
+  // the first call would return {id, name, comment} and the second
+  // {1, Smith, John, said "hi"\ntwice}.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the fields of the record. The fields and the span are only valid
+  //   until the next call to get_record() or to the reader.
+  //   An empty line is a record with a single empty field.
+  // - nullopt if already at the end of the file or the file is not open
+  std::optional<std::span<const std::string_view>> get_record();
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  CsvReader(const CsvReader& other) = delete;
+  CsvReader& operator=(const CsvReader& other) = delete;
+
+ private:
+  // Returns the index of the first separator or newline at or after pos
+  // in data that is not inside quotes, or len if there is none.
+  // in_quotes_ says whether data[pos] starts inside quotes, and is
+  // updated to whether the returned index is.
+  size_t find_structural(const char* data, size_t len, size_t pos);
+
+  // Turns the raw bytes of a field into the field's value: strips
+  // the surrounding quotes and unescapes doubled quotes (into
+  // unescaped_) if there are any.
+  std::string_view make_field(const char* data, size_t len);
+
+  // fields
+  BufferedFileReader& reader_;  // the reader we read records from
+  char separator_;              // the char between two fields
+  char quote_;                  // the char used to quote a field
+  bool in_quotes_;              // whether the scan is inside quotes
+
+  std::string record_;     // the bytes of the current record, if it had
+                           // to be copied out of the reader's buffer
+  std::string unescaped_;  // fields with their escaped quotes undone
+  std::vector<std::pair<size_t, size_t>> bounds_;  // where each field of
+                                                   // the record starts
+                                                   // and ends
+  std::vector<std::string_view> fields_;  // the fields of the record
+};
+
+#endif  // CSVREADER_HPP_
@@ -0,0 +1,256 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "Decoder.hpp"
+
+#if __has_include(<zlib.h>)
+#include <zlib.h>
+#define HAVE_ZLIB 1
+#endif
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define HAVE_ZSTD 1
+#endif
+
+using namespace std;
+
+namespace {
+
+#ifdef HAVE_ZLIB
+// gzip, including files of several gzip members one after another
+// (as written by pigz or by cat'ing .gz files together)
+class GzipCodec : public Codec {
+ public:
+  GzipCodec() : stream_{} { ok_ = inflateInit2(&stream_, 15 + 16) == Z_OK; }
+  ~GzipCodec() override { inflateEnd(&stream_); }
+
+  bool decode(string_view* in, string* out, size_t max_out) override {
+    if (!ok_) {
+      return false;
+    }
+    if (member_done_ && !in->empty()) {
+      // another member follows
+      inflateReset(&stream_);
+      member_done_ = false;
+    }
+    size_t old_size = out->size();
+    out->resize(old_size + max_out);
+    stream_.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(in->data()));
+    stream_.avail_in = static_cast<uInt>(in->size());
+    stream_.next_out = reinterpret_cast<Bytef*>(out->data() + old_size);
+    stream_.avail_out = static_cast<uInt>(max_out);
+
+    int result = inflate(&stream_, Z_NO_FLUSH);
+    in->remove_prefix(in->size() - stream_.avail_in);
+    out->resize(old_size + max_out - stream_.avail_out);
+    if (result == Z_STREAM_END) {
+      member_done_ = true;
+      return true;
+    }
+    return result == Z_OK || result == Z_BUF_ERROR;
+  }
+
+  bool finished() const override { return member_done_; }
+
+ private:
+  z_stream stream_;           // zlib's state
+  bool ok_;                   // whether stream_ was set up
+  bool member_done_ = false;  // whether the last member was complete
+};
+#endif  // HAVE_ZLIB
+
+#ifdef HAVE_ZSTD
+// zstd, which handles several frames one after another itself
+class ZstdCodec : public Codec {
+ public:
+  ZstdCodec() : stream_(ZSTD_createDStream()) {}
+  ~ZstdCodec() override { ZSTD_freeDStream(stream_); }
+
+  bool decode(string_view* in, string* out, size_t max_out) override {
+    if (stream_ == nullptr) {
+      return false;
+    }
+    size_t old_size = out->size();
+    out->resize(old_size + max_out);
+    ZSTD_inBuffer input{in->data(), in->size(), 0};
+    ZSTD_outBuffer output{out->data() + old_size, max_out, 0};
+    size_t result = ZSTD_decompressStream(stream_, &output, &input);
+    in->remove_prefix(input.pos);
+    out->resize(old_size + output.pos);
+    if (ZSTD_isError(result)) {
+      return false;
+    }
+    // 0 means a frame was completed and flushed
+    frame_done_ = result == 0;
+    return true;
+  }
+
+  bool finished() const override { return frame_done_; }
+
+ private:
+  ZSTD_DStream* stream_;     // zstd's state
+  bool frame_done_ = false;  // whether the last frame was complete
+};
+#endif  // HAVE_ZSTD
+
+}  // namespace
+
+unique_ptr<Codec> Decoder::make_codec(string_view prefix) {
+#ifdef HAVE_ZLIB
+  if (prefix.starts_with("\x1f\x8b")) {
+    return make_unique<GzipCodec>();
+  }
+#endif
+#ifdef HAVE_ZSTD
+  if (prefix.starts_with("\x28\xb5\x2f\xfd")) {
+    return make_unique<ZstdCodec>();
+  }
+#endif
+  return nullptr;
+}
+
+Decoder::Decoder(int fd, string prefix, unique_ptr<Codec> codec)
+    : fd_(fd),
+      wake_fd_(eventfd(0, EFD_CLOEXEC)),
+      input_(std::move(prefix)),
+      codec_(std::move(codec)) {
+  helper_ = thread(&Decoder::run, this);
+}
+
+Decoder::~Decoder() {
+  {
+    lock_guard<mutex> guard(lock_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  // the helper may be blocked reading a pipe that has nothing in it
+  uint64_t one = 1;
+  if (wake_fd_ >= 0 && write(wake_fd_, &one, sizeof(one)) < 0) {
+    // it still stops once the read returns
+  }
+  helper_.join();
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+  }
+}
+
+ssize_t Decoder::read(char* buf, size_t n) {
+  while (current_pos_ >= current_.size()) {
+    unique_lock<mutex> guard(lock_);
+    cv_.wait(guard, [this] { return !chunks_.empty() || done_; });
+    if (chunks_.empty()) {
+      return failed_ ? -1 : 0;
+    }
+    current_ = std::move(chunks_.front());
+    chunks_.pop_front();
+    current_pos_ = 0;
+    guard.unlock();
+    cv_.notify_all();
+  }
+  size_t count = min(n, current_.size() - current_pos_);
+  memcpy(buf, current_.data() + current_pos_, count);
+  current_pos_ += count;
+  return static_cast<ssize_t>(count);
+}
+
+void Decoder::run() {
+  string_view in(input_);
+  bool input_done = false;
+  while (true) {
+    string chunk;
+    while (chunk.size() < CHUNK_SIZE) {
+      if (in.empty() && !input_done) {
+        ssize_t result = read_input();
+        if (result < 0) {
+          finish(true);
+          return;
+        }
+        input_done = result == 0;
+        in = input_;
+        continue;
+      }
+      if (in.empty() && codec_->finished()) {
+        break;
+      }
+      // once all the input is taken, the codec may still be holding
+      // output back (zstd does), so it is called until it stops giving any
+      size_t in_before = in.size();
+      size_t out_before = chunk.size();
+      if (!codec_->decode(&in, &chunk, CHUNK_SIZE - chunk.size())) {
+        finish(true);  // corrupt
+        return;
+      }
+      if (in.size() == in_before && chunk.size() == out_before) {
+        if (in.empty()) {
+          break;  // nothing left to flush
+        }
+        finish(true);  // stuck on bytes it can't use
+        return;
+      }
+    }
+    if (chunk.empty()) {
+      finish(!codec_->finished());  // a truncated file is an error
+      return;
+    }
+    if (!push(std::move(chunk))) {
+      return;
+    }
+  }
+}
+
+ssize_t Decoder::read_input() {
+  struct pollfd fds[2] = {{fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+  while (true) {
+    if (wake_fd_ >= 0 && poll(fds, 2, -1) < 0 && errno != EINTR) {
+      return -1;
+    }
+    if (fds[1].revents != 0) {
+      return -1;  // being destroyed
+    }
+    input_.resize(CHUNK_SIZE);
+    ssize_t result = ::read(fd_, input_.data(), CHUNK_SIZE);
+    if (result == -1 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    }
+    input_.resize(max<ssize_t>(result, 0));
+    return result;
+  }
+}
+
+bool Decoder::push(string chunk) {
+  unique_lock<mutex> guard(lock_);
+  cv_.wait(guard, [this] { return chunks_.size() < MAX_CHUNKS || stop_; });
+  if (stop_) {
+    return false;
+  }
+  chunks_.push_back(std::move(chunk));
+  guard.unlock();
+  cv_.notify_all();
+  return true;
+}
+
+void Decoder::finish(bool failed) {
+  {
+    lock_guard<mutex> guard(lock_);
+    done_ = true;
+    failed_ = failed;
+  }
+  cv_.notify_all();
+}
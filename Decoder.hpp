@@ -0,0 +1,153 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef DECODER_HPP_
+#define DECODER_HPP_
+
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+// A Codec decompresses one compression format, a piece at a time.
+//
+// New formats are added by implementing this interface and recognising
+// their magic bytes in Decoder::make_codec().
+///////////////////////////////////////////////////////////////////////////////
+class Codec {
+ public:
+  virtual ~Codec() = default;
+
+  // Decompresses bytes from the front of in, appending what they
+  // decompress to onto out.
+  //
+  // Arguments:
+  // - in: the compressed bytes. Advanced past the bytes that were used;
+  //   any left over must be passed in again on the next call.
+  // - out: the string to append decompressed bytes to
+  // - max_out: the most bytes to append to out in this call
+  //
+  // Returns:
+  // - true if it worked
+  // - false if the compressed data is corrupt
+  virtual bool decode(std::string_view* in,
+                      std::string* out,
+                      size_t max_out) = 0;
+
+  // Returns whether the bytes decoded so far end at the end of a
+  // complete compressed stream, i.e. the input was not cut short.
+  virtual bool finished() const = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// A Decoder decompresses a gzip or zstd file as it is read.
+//
+// A helper thread reads the compressed file and decompresses it into a
+// small queue of chunks, while the reading thread takes decompressed
+// bytes off the front of the queue with read(). The helper stays at
+// most a few chunks ahead, so memory use does not grow with the file.
+//
+// Formats are only supported if their library (zlib, libzstd) was
+// installed when this was built.
+///////////////////////////////////////////////////////////////////////////////
+class Decoder {
+ public:
+  // Returns the Codec for the format whose magic bytes start prefix.
+  //
+  // Arguments:
+  // - prefix: the first bytes of the file (at least 4 to detect zstd)
+  //
+  // Returns:
+  // - a new Codec for the format
+  // - nullptr if prefix is not a supported compressed format
+  static std::unique_ptr<Codec> make_codec(std::string_view prefix);
+
+  // Constructor for a Decoder. Starts the helper thread.
+  //
+  // Arguments:
+  // - fd: the file descriptor to read the compressed bytes from.
+  //   The Decoder does NOT take ownership of it, but it must stay
+  //   open until the Decoder is destroyed.
+  // - prefix: compressed bytes that were already read from fd,
+  //   which come before the rest of it
+  // - codec: the Codec for the format, from make_codec()
+  Decoder(int fd, std::string prefix, std::unique_ptr<Codec> codec);
+
+  // Destructor for a Decoder. Stops and joins the helper thread.
+  //
+  // Arguments: None
+  ~Decoder();
+
+  // Reads decompressed bytes, blocking until the helper thread has
+  // decompressed some.
+  //
+  // Arguments:
+  // - buf: where to put the bytes
+  // - n: the most bytes to read
+  //
+  // Returns:
+  // - the number of bytes read
+  // - 0 at the end of the compressed stream
+  // - -1 if reading the file failed or the data is corrupt or truncated
+  ssize_t read(char* buf, size_t n);
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  Decoder(const Decoder& other) = delete;
+  Decoder& operator=(const Decoder& other) = delete;
+
+ private:
+  // Constants
+  static constexpr size_t CHUNK_SIZE = 65536;  // bytes per read and chunk
+  static constexpr size_t MAX_CHUNKS = 4;      // chunks the helper may
+                                               // get ahead by
+
+  // The body of the helper thread
+  void run();
+
+  // Reads the next compressed bytes into input_. Returns the number of
+  // bytes read, 0 at the end of the file, -1 on error or if stopped.
+  ssize_t read_input();
+
+  // Hands a chunk to the reading thread, waiting for room in the queue.
+  // Returns false if the Decoder is being destroyed.
+  bool push(std::string chunk);
+
+  // Marks the end of the output, as failed or not.
+  void finish(bool failed);
+
+  // fields
+  int fd_;                        // the compressed file
+  int wake_fd_;                   // eventfd to wake the helper to stop it
+  std::string input_;             // compressed bytes read from fd_
+  std::unique_ptr<Codec> codec_;  // decompresses input_
+
+  std::mutex lock_;              // guards the fields below it
+  std::condition_variable cv_;   // signalled when any of them change
+  std::deque<std::string> chunks_;  // decompressed chunks, in order
+  bool done_ = false;               // whether the helper has finished
+  bool failed_ = false;             // whether it finished with an error
+  bool stop_ = false;               // whether the helper should stop
+
+  std::string current_;     // the chunk read() is taking bytes from
+  size_t current_pos_ = 0;  // how much of current_ has been read
+
+  std::thread helper_;  // the helper thread, started last
+};
+
+#endif  // DECODER_HPP_
@@ -0,0 +1,69 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <queue>
+
+#include "DelimiterMatcher.hpp"
+using namespace std;
+
+DelimiterMatcher::DelimiterMatcher(const vector<string>& delims)
+    : delims_(delims), transitions_(kAlphabet, -1), match_length_(1, 0) {
+  // Build the trie. -1 marks a missing edge until the failure
+  // links below fill it in.
+  for (const string& delim : delims_) {
+    int32_t state = kStart;
+    for (char c : delim) {
+      size_t edge = state * kAlphabet + static_cast<unsigned char>(c);
+      if (transitions_[edge] == -1) {
+        transitions_[edge] = static_cast<int32_t>(match_length_.size());
+        transitions_.resize(transitions_.size() + kAlphabet, -1);
+        match_length_.push_back(0);
+      }
+      state = transitions_[edge];
+    }
+    if (!delim.empty()) {
+      match_length_[state] = static_cast<int32_t>(delim.length());
+    }
+  }
+
+  // Breadth first, turn every missing edge into the edge of the
+  // failure state (the longest proper suffix that is also in the trie).
+  // Since the failure state is closer to the root, its edges are
+  // already complete by the time we get here.
+  vector<int32_t> fail(match_length_.size(), kStart);
+  queue<int32_t> to_visit;
+  for (size_t c = 0; c < kAlphabet; c++) {
+    int32_t& child = transitions_[c];
+    if (child == -1) {
+      child = kStart;
+    } else {
+      to_visit.push(child);
+    }
+  }
+  while (!to_visit.empty()) {
+    int32_t state = to_visit.front();
+    to_visit.pop();
+    // a delimiter ending at the failure state also ends here
+    if (match_length_[state] == 0) {
+      match_length_[state] = match_length_[fail[state]];
+    }
+    for (size_t c = 0; c < kAlphabet; c++) {
+      int32_t& child = transitions_[state * kAlphabet + c];
+      int32_t fallback = transitions_[fail[state] * kAlphabet + c];
+      if (child == -1) {
+        child = fallback;
+      } else {
+        fail[child] = fallback;
+        to_visit.push(child);
+      }
+    }
+  }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef DELIMITERMATCHER_HPP_
+#define DELIMITERMATCHER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// A DelimiterMatcher finds delimiters that are strings rather than
+// single characters (e.g. "\r\n", "||" or "<SEP>") in a stream of chars.
+//
+// It is an Aho-Corasick automaton compiled down to a full transition
+// table, so each char of input costs exactly one table lookup no matter
+// how many delimiters there are, and no char is ever looked at twice.
+// The caller feeds chars one at a time with next(), starting from
+// kStart, and keeps the returned state between calls; this is what lets
+// a delimiter be found even when it is split across two reads.
+//
+// If several delimiters end at the same char, the longest one is
+// reported. A delimiter is reported as soon as it ends, so if one
+// delimiter is a prefix of another (e.g. "\r" and "\r\n"), the shorter
+// one always wins.
+///////////////////////////////////////////////////////////////////////////////
+class DelimiterMatcher {
+ public:
+  // The state before any chars have been matched
+  static constexpr int32_t kStart = 0;
+
+  // Constructor for a DelimiterMatcher. Builds the automaton.
+  //
+  // Arguments:
+  // - delims: the delimiters to look for. Empty strings are ignored.
+  DelimiterMatcher(const std::vector<std::string>& delims);
+
+  // Advances the automaton by one char.
+  //
+  // Arguments:
+  // - state: the current state
+  // - c: the next char of input
+  //
+  // Returns:
+  // - the state after reading c
+  int32_t next(int32_t state, char c) const {
+    return transitions_[static_cast<size_t>(state) * kAlphabet +
+                        static_cast<unsigned char>(c)];
+  }
+
+  // Returns the length of the delimiter that ends at the char that lead
+  // to this state, or 0 if no delimiter ends there.
+  //
+  // Arguments:
+  // - state: a state returned by next()
+  int32_t match_length(int32_t state) const { return match_length_[state]; }
+
+  // Returns the delimiters this matcher looks for.
+  const std::vector<std::string>& delims() const { return delims_; }
+
+ private:
+  static constexpr size_t kAlphabet = 256;
+
+  std::vector<std::string> delims_;    // the delimiters
+  std::vector<int32_t> transitions_;   // kAlphabet entries per state
+  std::vector<int32_t> match_length_;  // one entry per state
+};
+
+#endif  // DELIMITERMATCHER_HPP_
@@ -0,0 +1,59 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef DELIMS_HPP_
+#define DELIMS_HPP_
+
+#include <array>
+#include <string_view>
+
+// A lookup table with one entry per possible char value,
+// true for the chars that are delimiters.
+using DelimTable = std::array<bool, 256>;
+
+// Builds the lookup table for the delimiters in the given string.
+//
+// Arguments:
+// - delims: a string containing all of the delimiter characters
+//
+// Returns:
+// - the lookup table for those delimiters
+constexpr DelimTable make_delim_table(std::string_view delims) {
+  DelimTable table{};
+  for (char c : delims) {
+    table[static_cast<unsigned char>(c)] = true;
+  }
+  return table;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Delims is a set of delimiter characters fixed at compile time.
+//
+// For example, Delims<',', '\n'> is the set containing ',' and '\n'.
+// Passing one to a reader instead of a std::string lets the delimiter
+// lookup table be built by the compiler rather than at runtime. The
+// reader still scans through its runtime copy of the table, so this
+// only saves building the table.
+///////////////////////////////////////////////////////////////////////////////
+template <char... Cs>
+struct Delims {
+  // The lookup table for this set of delimiters
+  static constexpr DelimTable kTable = [] {
+    DelimTable table{};
+    ((table[static_cast<unsigned char>(Cs)] = true), ...);
+    return table;
+  }();
+};
+
+// The default delimiters used by the readers: white space characters
+using DefaultDelims = Delims<'\r', '\n', '\t', ' '>;
+
+#endif  // DELIMS_HPP_
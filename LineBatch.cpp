@@ -0,0 +1,41 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "LineBatch.hpp"
+using namespace std;
+
+size_t LineBatch::read(BufferedFileReader& reader,
+                       size_t max_lines,
+                       size_t max_bytes) {
+  clear();
+  // leave room for one more line after the limit is reached
+  max_bytes = min<size_t>(max_bytes, numeric_limits<uint32_t>::max() / 2);
+
+  size_t lines = 0;
+  while (lines < max_lines && arena_.size() < max_bytes) {
+    if (!reader.read_line(arena_, token_offsets_, token_lengths_)) {
+      break;
+    }
+    line_starts_.push_back(static_cast<uint32_t>(token_offsets_.size()));
+    lines++;
+  }
+  return lines;
+}
+
+void LineBatch::clear() {
+  arena_.clear();
+  token_offsets_.clear();
+  token_lengths_.clear();
+  line_starts_.resize(1);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef LINEBATCH_HPP_
+#define LINEBATCH_HPP_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BufferedFileReader.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// A LineBatch holds many lines read from a BufferedFileReader at once.
+//
+// Instead of a vector<string> per line, the bytes of every token in the
+// batch are stored back to back in a single arena, with separate arrays
+// (struct-of-arrays) holding each token's offset and length and the
+// index of each line's first token. Scanning tokens walks these arrays
+// in order, and the whole batch is released at once by clear(), which
+// keeps the memory around for the next read().
+///////////////////////////////////////////////////////////////////////////////
+class LineBatch {
+ public:
+  // Constructor for an empty LineBatch.
+  //
+  // Arguments: None
+  LineBatch() = default;
+
+  // Clears the batch, then reads lines from the reader into it until
+  // either max_lines lines have been read, at least max_bytes bytes of
+  // tokens are stored, or the reader reaches the end of the file.
+  // Lines are read exactly as BufferedFileReader::get_line() would
+  // read them, so a line is never split between two batches
+  // (and a batch may go over max_bytes by up to one line).
+  //
+  // Arguments:
+  // - reader: the reader to read lines from
+  // - max_lines: the maximum number of lines to read
+  // - max_bytes: the number of token bytes after which to stop reading.
+  //   A batch holds less than 4 GiB, larger values are clamped.
+  //
+  // Returns:
+  // - the number of lines read. 0 if the reader was already at the
+  //   end of the file or is not open.
+  size_t read(BufferedFileReader& reader, size_t max_lines, size_t max_bytes);
+
+  // Releases every line and token in the batch.
+  // Allocated memory is kept to be reused by the next read().
+  //
+  // Arguments: None
+  void clear();
+
+  // Returns the number of lines in the batch.
+  size_t num_lines() const { return line_starts_.size() - 1; }
+
+  // Returns the number of tokens in the batch, across all lines.
+  size_t num_tokens() const { return token_offsets_.size(); }
+
+  // Returns the number of token bytes stored in the batch.
+  size_t num_bytes() const { return arena_.size(); }
+
+  // Returns the number of tokens in the specified line.
+  //
+  // Arguments:
+  // - line: the index of the line in the batch, less than num_lines()
+  size_t line_size(size_t line) const {
+    return line_starts_.at(line + 1) - line_starts_.at(line);
+  }
+
+  // Returns the token with the specified index in the batch.
+  // The view is valid until the next call to read() or clear().
+  //
+  // Arguments:
+  // - index: the index of the token in the batch, less than num_tokens()
+  std::string_view token(size_t index) const {
+    return {arena_.data() + token_offsets_.at(index),
+            token_lengths_.at(index)};
+  }
+
+  // Returns the i'th token of the specified line.
+  // The view is valid until the next call to read() or clear().
+  //
+  // Arguments:
+  // - line: the index of the line in the batch, less than num_lines()
+  // - i: the index of the token in that line, less than line_size(line)
+  std::string_view token(size_t line, size_t i) const {
+    return token(line_starts_.at(line) + i);
+  }
+
+  // Direct access to the columns, for code that wants to scan them
+  // without going through token().
+  // - arena(): the bytes of every token, back to back
+  // - token_offsets(): where each token starts in arena()
+  // - token_lengths(): how long each token is
+  // - line_starts(): the index of the first token of each line, followed
+  //   by num_tokens(), so line i holds the tokens
+  //   [line_starts()[i], line_starts()[i + 1])
+  const std::string& arena() const { return arena_; }
+  const std::vector<uint32_t>& token_offsets() const { return token_offsets_; }
+  const std::vector<uint32_t>& token_lengths() const { return token_lengths_; }
+  const std::vector<uint32_t>& line_starts() const { return line_starts_; }
+
+ private:
+  std::string arena_;                    // the bytes of every token
+  std::vector<uint32_t> token_offsets_;  // offset of each token in arena_
+  std::vector<uint32_t> token_lengths_;  // length of each token
+  std::vector<uint32_t> line_starts_{0};  // first token of each line,
+                                          // plus one past the last token
+};
+
+#endif  // LINEBATCH_HPP_
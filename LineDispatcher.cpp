@@ -0,0 +1,98 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <algorithm>
+#include <thread>
+
+#include "BufferedFileReader.hpp"
+#include "LineDispatcher.hpp"
+using namespace std;
+
+LineDispatcher::LineDispatcher(size_t num_workers,
+                               Worker worker,
+                               Writer writer,
+                               bool ordered,
+                               size_t max_lines,
+                               size_t capacity)
+    : num_workers_(max<size_t>(num_workers, 1)),
+      worker_(std::move(worker)),
+      writer_(std::move(writer)),
+      ordered_(ordered),
+      max_lines_(max<size_t>(max_lines, 1)),
+      todo_(capacity + num_workers_),
+      free_(capacity + num_workers_) {
+  // enough jobs to keep the queue full while every worker has one.
+  // free_ can hold all of them, so giving one back never waits
+  for (size_t i = 0; i < capacity + num_workers_; i++) {
+    jobs_.push_back(make_unique<Job>());
+    free_.push(jobs_.back().get());
+  }
+}
+
+uint64_t LineDispatcher::run(const string& fname, const string& delims) {
+  BufferedFileReader reader(fname, delims);
+  if (!reader.good()) {
+    return 0;
+  }
+  next_to_write_ = 0;
+  vector<thread> workers;
+  for (size_t i = 0; i < num_workers_; i++) {
+    workers.emplace_back(&LineDispatcher::work, this);
+  }
+
+  uint64_t num_lines = 0;
+  for (uint64_t sequence = 0;; sequence++) {
+    // waits here when every job is taken, until a worker is done
+    Job* job = free_.pop();
+    size_t read = job->batch.read(reader, max_lines_, SIZE_MAX);
+    if (read == 0) {
+      free_.push(job);
+      break;
+    }
+    num_lines += read;
+    job->sequence = sequence;
+    job->out.clear();
+    todo_.push(job);
+  }
+
+  for (size_t i = 0; i < num_workers_; i++) {
+    todo_.push(nullptr);
+  }
+  for (thread& worker : workers) {
+    worker.join();
+  }
+  return num_lines;
+}
+
+void LineDispatcher::work() {
+  for (Job* job = todo_.pop(); job != nullptr; job = todo_.pop()) {
+    worker_(job->batch, &job->out);
+    finish(job);
+  }
+}
+
+void LineDispatcher::finish(Job* job) {
+  lock_guard<mutex> guard(write_lock_);
+  if (!ordered_) {
+    writer_(job->out);
+    free_.push(job);
+    return;
+  }
+  // write this job and any after it that were waiting on it
+  done_.emplace(job->sequence, job);
+  auto next = done_.begin();
+  while (next != done_.end() && next->first == next_to_write_) {
+    writer_(next->second->out);
+    free_.push(next->second);
+    next_to_write_++;
+    next = done_.erase(next);
+  }
+}
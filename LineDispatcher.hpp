@@ -0,0 +1,126 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef LINEDISPATCHER_HPP_
+#define LINEDISPATCHER_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LineBatch.hpp"
+#include "MpmcQueue.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// A LineDispatcher reads a file on one thread and spreads the work of
+// processing its lines over a pool of worker threads.
+//
+// Lines are read into LineBatches, which go to the workers through a
+// bounded MpmcQueue; each worker takes whichever batch is next. Batches
+// are recycled through a second queue, so there are never more than a
+// fixed number of them, and reading waits when the workers fall behind.
+//
+// A worker appends the output of a batch to a string, which is then
+// handed to the writer. In ordered mode, outputs are written in the
+// order of the batches in the file, as if one thread had done all the
+// work; otherwise each is written as soon as it is done.
+///////////////////////////////////////////////////////////////////////////////
+class LineDispatcher {
+ public:
+  // Processes one batch of lines on a worker thread.
+  //
+  // Arguments:
+  // - batch: the lines to process
+  // - out: where to append the output of the batch, which starts empty
+  using Worker = std::function<void(const LineBatch& batch, std::string* out)>;
+
+  // Writes the output of one batch. Only called on one thread at a
+  // time, so it needs no locking of its own.
+  //
+  // Arguments:
+  // - out: the output of the batch
+  using Writer = std::function<void(std::string_view out)>;
+
+  // Constructor for a LineDispatcher. Nothing is read until run().
+  //
+  // Arguments:
+  // - num_workers: the number of worker threads (at least one)
+  // - worker: what to do with each batch
+  // - writer: what to do with the output of each batch
+  // - ordered: whether to write outputs in the order of the file
+  // - max_lines: the most lines in each batch
+  // - capacity: the most batches waiting for a worker, rounded up to
+  //   a power of two
+  LineDispatcher(size_t num_workers,
+                 Worker worker,
+                 Writer writer,
+                 bool ordered = false,
+                 size_t max_lines = 256,
+                 size_t capacity = 16);
+
+  // Reads the lines of the file and has the workers process all of
+  // them, returning once every output has been written.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  //
+  // Returns:
+  // - the number of lines read, 0 if the file could not be opened
+  uint64_t run(const std::string& fname,
+               const std::string& delims = "\r\n\t ");
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  LineDispatcher(const LineDispatcher& other) = delete;
+  LineDispatcher& operator=(const LineDispatcher& other) = delete;
+
+ private:
+  // A batch, along with where it is in the file and its output
+  struct Job {
+    uint64_t sequence;  // the index of the batch in the file
+    LineBatch batch;    // the lines
+    std::string out;    // the output of worker_
+  };
+
+  // The body of each worker thread
+  void work();
+
+  // Hands the output of a finished job to writer_, in order if
+  // ordered_, and gives the jobs that were written back to free_.
+  void finish(Job* job);
+
+  // fields
+  size_t num_workers_;  // the number of worker threads
+  Worker worker_;       // processes a batch
+  Writer writer_;       // writes the output of a batch
+  bool ordered_;        // whether to write outputs in file order
+  size_t max_lines_;    // lines per batch
+
+  std::vector<std::unique_ptr<Job>> jobs_;  // every job, recycled
+  MpmcQueue<Job*> todo_;  // jobs for the workers; nullptr to stop
+  MpmcQueue<Job*> free_;  // jobs that can be reused
+
+  std::mutex write_lock_;  // held while calling writer_, and guards
+                           // the two fields below it
+  uint64_t next_to_write_ = 0;       // the sequence to write next
+  std::map<uint64_t, Job*> done_;    // finished jobs waiting for their
+                                     // turn to be written (ordered only)
+};
+
+#endif  // LINEDISPATCHER_HPP_
@@ -0,0 +1,196 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#include "LineIndex.hpp"
+using namespace std;
+
+// The first bytes of every index file, including a format version
+static constexpr string_view kMagic = "LIDX0001";
+
+// helper functions
+
+// Appends value to out as a LEB128 variable length integer:
+// 7 bits per byte, with the high bit set on all but the last byte.
+static void put_varint(string* out, uint64_t value) {
+  while (value >= 0x80) {
+    *out += static_cast<char>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  *out += static_cast<char>(value);
+}
+
+// Reads a variable length integer written by put_varint from in,
+// starting at *pos. Advances *pos past it.
+// Returns false if in ends before the integer does.
+static bool get_varint(const string& in, size_t* pos, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (*pos >= in.length()) {
+      return false;
+    }
+    uint8_t byte = static_cast<uint8_t>(in[(*pos)++]);
+    *value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+LineIndex::LineIndex(const string& fname, uint64_t interval)
+    : interval_(max<uint64_t>(interval, 1)), num_lines_(0), file_size_(0) {
+  BufferedFileReader reader(fname);
+  bool at_line_start = true;
+
+  while (true) {
+    string_view view = reader.peek_buffer();
+    if (view.empty()) {
+      break;
+    }
+    size_t pos = 0;
+    while (pos < view.size()) {
+      if (at_line_start) {
+        if (num_lines_ % interval_ == 0) {
+          checkpoints_.push_back(file_size_ + pos);
+        }
+        num_lines_++;
+        at_line_start = false;
+      }
+      const void* newline =
+          memchr(view.data() + pos, '\n', view.size() - pos);
+      if (newline == nullptr) {
+        break;
+      }
+      pos = static_cast<const char*>(newline) - view.data() + 1;
+      at_line_start = true;
+    }
+    file_size_ += view.size();
+    reader.consume(view.size());
+  }
+}
+
+bool LineIndex::save(const string& index_fname) const {
+  string contents(kMagic);
+  put_varint(&contents, interval_);
+  put_varint(&contents, num_lines_);
+  put_varint(&contents, file_size_);
+  put_varint(&contents, checkpoints_.size());
+  uint64_t prev = 0;
+  for (uint64_t checkpoint : checkpoints_) {
+    put_varint(&contents, checkpoint - prev);
+    prev = checkpoint;
+  }
+
+  int fd = open(index_fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  size_t written = 0;
+  while (written < contents.length()) {
+    ssize_t result =
+        write(fd, contents.data() + written, contents.length() - written);
+    if (result == -1) {
+      if (errno != EINTR) {
+        close(fd);
+        return false;
+      }
+      continue;
+    }
+    written += result;
+  }
+  return close(fd) == 0;
+}
+
+optional<LineIndex> LineIndex::load(const string& index_fname) {
+  int fd = open(index_fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullopt;
+  }
+  string contents;
+  char buf[4096];
+  while (true) {
+    ssize_t result = read(fd, buf, sizeof(buf));
+    if (result == -1) {
+      if (errno != EINTR) {
+        close(fd);
+        return nullopt;
+      }
+      continue;
+    }
+    if (result == 0) {
+      break;
+    }
+    contents.append(buf, result);
+  }
+  close(fd);
+
+  if (contents.compare(0, kMagic.length(), kMagic) != 0) {
+    return nullopt;
+  }
+  LineIndex index;
+  size_t pos = kMagic.length();
+  uint64_t count = 0;
+  if (!get_varint(contents, &pos, &index.interval_) ||
+      !get_varint(contents, &pos, &index.num_lines_) ||
+      !get_varint(contents, &pos, &index.file_size_) ||
+      !get_varint(contents, &pos, &count) || index.interval_ == 0 ||
+      count != (index.num_lines_ + index.interval_ - 1) / index.interval_ ||
+      count > contents.length() - pos) {
+    // every checkpoint takes at least one byte, so a count bigger than
+    // what is left is corrupt, and must not be reserved
+    return nullopt;
+  }
+  uint64_t checkpoint = 0;
+  index.checkpoints_.reserve(count);
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t delta = 0;
+    if (!get_varint(contents, &pos, &delta)) {
+      return nullopt;
+    }
+    checkpoint += delta;
+    index.checkpoints_.push_back(checkpoint);
+  }
+  return index;
+}
+
+bool LineIndex::seek_to_line(BufferedFileReader& reader, uint64_t line) const {
+  if (line >= num_lines_) {
+    return false;
+  }
+  if (!reader.seek(static_cast<off_t>(checkpoints_.at(line / interval_)))) {
+    return false;
+  }
+
+  // skip forward from the checkpoint
+  uint64_t to_skip = line % interval_;
+  while (to_skip > 0) {
+    string_view view = reader.peek_buffer();
+    if (view.empty()) {
+      return false;
+    }
+    const void* newline = memchr(view.data(), '\n', view.size());
+    if (newline == nullptr) {
+      reader.consume(view.size());
+      continue;
+    }
+    reader.consume(static_cast<const char*>(newline) - view.data() + 1);
+    to_skip--;
+  }
+  return true;
+}
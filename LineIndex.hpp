@@ -0,0 +1,102 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef LINEINDEX_HPP_
+#define LINEINDEX_HPP_
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "BufferedFileReader.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// A LineIndex gives fast access to line N of a file.
+//
+// Building the index scans the file once and records the offset at which
+// every interval'th line starts (a "checkpoint"). To get to line N, a
+// reader is moved to the checkpoint at or before N, and at most
+// interval - 1 lines are skipped from there.
+//
+// The index can be saved next to the file and loaded again later. On
+// disk, each checkpoint is stored as the distance from the previous
+// one, as a variable length integer, so it takes a couple of bytes.
+///////////////////////////////////////////////////////////////////////////////
+class LineIndex {
+ public:
+  // Constructor for a LineIndex. Builds the index of the specified file
+  // by reading all of it once.
+  // Lines end with '\n'. If the file does not end with a '\n', the
+  // bytes after the last one still count as a line.
+  //
+  // Arguments:
+  // - fname: The name of the file to index
+  // - interval: the number of lines between two checkpoints.
+  //   Smaller values make seek_to_line() faster and the index bigger.
+  LineIndex(const std::string& fname, uint64_t interval = 1024);
+
+  // Writes the index to the specified file, replacing its contents.
+  //
+  // Arguments:
+  // - index_fname: the name of the file to write the index to
+  //
+  // Returns:
+  // - true if the index was written
+  // - false if the file could not be written
+  bool save(const std::string& index_fname) const;
+
+  // Reads an index back from a file written by save().
+  //
+  // Arguments:
+  // - index_fname: the name of the file to read the index from
+  //
+  // Returns:
+  // - the index
+  // - nullopt if the file could not be read or is not an index
+  static std::optional<LineIndex> load(const std::string& index_fname);
+
+  // Moves the reader to the start of the specified line, so that the
+  // next call to get_line() returns that line.
+  // The reader must have the file this index was built from open.
+  //
+  // Arguments:
+  // - reader: the reader to move
+  // - line: the number of the line, starting from 0
+  //
+  // Returns:
+  // - true if the reader was moved
+  // - false if the file does not have that many lines
+  bool seek_to_line(BufferedFileReader& reader, uint64_t line) const;
+
+  // Returns the number of lines in the indexed file.
+  uint64_t num_lines() const { return num_lines_; }
+
+  // Returns the number of lines between two checkpoints.
+  uint64_t interval() const { return interval_; }
+
+  // Returns the size in bytes of the indexed file when it was indexed.
+  // Can be compared against the current size to detect a stale index.
+  uint64_t file_size() const { return file_size_; }
+
+ private:
+  // Constructor for load(), which fills in the fields itself
+  LineIndex() = default;
+
+  uint64_t interval_;                 // lines between two checkpoints
+  uint64_t num_lines_;                // lines in the file
+  uint64_t file_size_;                // bytes in the file
+  std::vector<uint64_t> checkpoints_;  // offset of line i * interval_
+};
+
+#endif  // LINEINDEX_HPP_
@@ -0,0 +1,179 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef MPMCQUEUE_HPP_
+#define MPMCQUEUE_HPP_
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+// A MpmcQueue is a fixed size queue that any number of threads can push
+// to and pop from at once, without locks.
+//
+// It is Dmitry Vyukov's bounded MPMC queue: every cell has a sequence
+// number saying whose turn it is to use it, so a push or pop only takes
+// a position with one atomic operation, and then only touches its own
+// cell. The blocking push() and pop() take a position straight away and
+// wait (with std::atomic::wait) for their cell to be ready, so the
+// queue hands out cells in the order threads arrived.
+///////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class MpmcQueue {
+ public:
+  // Constructor for a MpmcQueue.
+  //
+  // Arguments:
+  // - capacity: the most items in the queue at once, rounded up to a
+  //   power of two
+  explicit MpmcQueue(size_t capacity)
+      : mask_(std::bit_ceil(capacity < 2 ? 2 : capacity) - 1),
+        cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+    for (size_t i = 0; i <= mask_; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Adds item to the back of the queue, unless the queue is full.
+  //
+  // Arguments:
+  // - item: the item to add. Only moved from if it was added.
+  //
+  // Returns:
+  // - true if the item was added
+  // - false if the queue is full
+  bool try_push(T& item) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[pos & mask_];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      if (sequence == pos) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          fill(cell, pos, item);
+          return true;
+        }
+      } else if (sequence < pos) {
+        return false;  // the cell still holds an item from a lap ago
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Adds item to the back of the queue, waiting for room if it is full.
+  //
+  // Arguments:
+  // - item: the item to add
+  void push(T item) {
+    size_t pos = enqueue_pos_.fetch_add(1, std::memory_order_relaxed);
+    Cell& cell = cells_[pos & mask_];
+    wait_for(cell, pos);
+    fill(cell, pos, item);
+  }
+
+  // Removes the item at the front of the queue, unless it is empty.
+  //
+  // Arguments:
+  // - item: where to move the item to
+  //
+  // Returns:
+  // - true if an item was removed
+  // - false if the queue is empty
+  bool try_pop(T& item) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[pos & mask_];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      if (sequence == pos + 1) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          item = empty(cell, pos);
+          return true;
+        }
+      } else if (sequence < pos + 1) {
+        return false;  // nothing has been pushed into the cell yet
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Removes the item at the front of the queue, waiting for one to be
+  // pushed if it is empty.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the item
+  T pop() {
+    size_t pos = dequeue_pos_.fetch_add(1, std::memory_order_relaxed);
+    Cell& cell = cells_[pos & mask_];
+    wait_for(cell, pos + 1);
+    return empty(cell, pos);
+  }
+
+  // Returns the most items the queue can hold.
+  size_t capacity() const { return mask_ + 1; }
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  MpmcQueue(const MpmcQueue& other) = delete;
+  MpmcQueue& operator=(const MpmcQueue& other) = delete;
+
+ private:
+  // Constants
+  static constexpr size_t kCacheLine = 64;
+
+  // A slot in the queue. For the push at position pos, the cell is
+  // free when sequence == pos, and holds its item once sequence ==
+  // pos + 1, until the pop at that position sets it to pos + capacity
+  // for the push one lap later.
+  struct alignas(kCacheLine) Cell {
+    std::atomic<size_t> sequence;
+    T item;
+  };
+
+  // Waits until the cell's sequence number reaches sequence
+  void wait_for(Cell& cell, size_t sequence) {
+    size_t seen = cell.sequence.load(std::memory_order_acquire);
+    while (seen != sequence) {
+      cell.sequence.wait(seen, std::memory_order_acquire);
+      seen = cell.sequence.load(std::memory_order_acquire);
+    }
+  }
+
+  // Stores item in the cell taken for the push at pos
+  void fill(Cell& cell, size_t pos, T& item) {
+    cell.item = std::move(item);
+    cell.sequence.store(pos + 1, std::memory_order_release);
+    cell.sequence.notify_all();
+  }
+
+  // Takes the item out of the cell taken for the pop at pos
+  T empty(Cell& cell, size_t pos) {
+    T item = std::move(cell.item);
+    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+    cell.sequence.notify_all();
+    return item;
+  }
+
+  size_t mask_;                    // capacity - 1
+  std::unique_ptr<Cell[]> cells_;  // the cells, used round and round
+  alignas(kCacheLine) std::atomic<size_t> enqueue_pos_{0};  // next push
+  alignas(kCacheLine) std::atomic<size_t> dequeue_pos_{0};  // next pop
+};
+
+#endif  // MPMCQUEUE_HPP_
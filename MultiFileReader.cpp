@@ -0,0 +1,145 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <cstdint>
+#include <utility>
+
+#include "MultiFileReader.hpp"
+using namespace std;
+
+MultiFileReader::MultiFileReader(const vector<string>& fnames,
+                                 const string& delims,
+                                 JoinMode join)
+    : MultiFileReader(fnames, join, [delims](const string& fname) {
+        return make_unique<BufferedFileReader>(fname, delims);
+      }) {}
+
+MultiFileReader::MultiFileReader(const vector<string>& fnames,
+                                 const vector<string>& delims,
+                                 JoinMode join)
+    : MultiFileReader(fnames, join, [delims](const string& fname) {
+        return make_unique<BufferedFileReader>(fname, delims);
+      }) {}
+
+MultiFileReader::MultiFileReader(const vector<string>& fnames,
+                                 JoinMode join,
+                                 Opener open)
+    : fnames_(fnames), open_(std::move(open)), join_(join) {
+  if (fnames_.empty()) {
+    return;
+  }
+  // the first file is opened just like the rest, so that the second
+  // one is already being opened when reading starts
+  prefetch(0);
+  index_ = static_cast<size_t>(-1);
+  next_file();
+}
+
+void MultiFileReader::prefetch(size_t index) {
+  if (index >= fnames_.size()) {
+    return;
+  }
+  // constructing the reader opens the file and reads its first buffer
+  next_ = async(launch::async, [fname = fnames_[index], open = open_]() {
+    return open(fname);
+  });
+}
+
+void MultiFileReader::next_file() {
+  index_++;
+  if (!next_.valid()) {
+    current_ = nullptr;
+    index_ = fnames_.size();
+    return;
+  }
+  current_ = next_.get();
+  prefetch(index_ + 1);
+}
+
+string_view MultiFileReader::peek() {
+  while (current_ != nullptr) {
+    string_view view = current_->peek_buffer();
+    if (!view.empty()) {
+      return view;
+    }
+    // a file that could not be opened reads as an empty one
+    next_file();
+  }
+  return {};
+}
+
+char MultiFileReader::get_char() {
+  string_view view = peek();
+  if (view.empty()) {
+    return EOF;
+  }
+  current_->consume(1);
+  return view.front();
+}
+
+optional<string> MultiFileReader::get_token() {
+  optional<string> token;
+  while (current_ != nullptr) {
+    optional<string> part = current_->get_token();
+    if (!token.has_value()) {
+      token = std::move(part);
+    } else if (part.has_value()) {
+      token->append(part.value());
+    }
+    if (current_->good()) {
+      return token;  // the token ended at a delimiter
+    }
+    // the end of the file ended the token
+    next_file();
+    if (token.has_value() && join_ == JoinMode::kSeparate) {
+      break;
+    }
+  }
+  return token;
+}
+
+optional<vector<string>> MultiFileReader::get_line() {
+  vector<string> line;
+  string token;          // the token being read when a file ended
+  bool started = false;  // whether any of the line has been read
+  string arena;
+  vector<uint32_t> offsets;
+  vector<uint32_t> lengths;
+  while (current_ != nullptr) {
+    arena.clear();
+    offsets.clear();
+    lengths.clear();
+    // the reader keeps the bytes after its last whole token in the
+    // arena, which is what the end of a file cuts off
+    current_->read_line(arena, offsets, lengths);
+    size_t rest = offsets.empty() ? 0 : offsets.back() + lengths.back();
+    started = started || !offsets.empty() || rest < arena.size();
+    for (size_t i = 0; i < offsets.size(); i++) {
+      token.append(arena, offsets[i], lengths[i]);
+      line.push_back(std::move(token));
+      token.clear();
+    }
+    token.append(arena, rest);
+    if (current_->good()) {
+      return line;  // the line ended at a newline
+    }
+    next_file();
+    if (started && join_ == JoinMode::kSeparate) {
+      break;  // the end of a file ends the line
+    }
+  }
+  if (!started) {
+    return nullopt;
+  }
+  // the last line of a file, with no newline after it
+  line.push_back(std::move(token));
+  return line;
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef MULTIFILEREADER_HPP_
+#define MULTIFILEREADER_HPP_
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BufferedFileReader.hpp"
+#include "Delims.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// A MultiFileReader reads a list of files, in order, as if they were one
+// long file (e.g. the segments of a rotated log).
+//
+// While one file is being read, the next one is opened and its first
+// buffer is read on another thread, so moving on to the next file does
+// not have to wait for the disk. Files that can't be opened are skipped.
+//
+// Each file is read by its own BufferedFileReader, built with the same
+// delimiters the MultiFileReader was given, and tokens and lines are
+// read with that reader's get_token()/get_line() logic. The
+// MultiFileReader only joins what is left over at the end of one file
+// with the start of the next one.
+///////////////////////////////////////////////////////////////////////////////
+class MultiFileReader {
+ public:
+  // How tokens and lines are treated where one file ends and the next
+  // one starts.
+  enum class JoinMode {
+    kSeparate,     // the end of each file ends the token and line being
+                   // read, as if every file ended with a newline
+    kConcatenate,  // the files are read as if joined with cat, so a
+                   // token or line may start in one file and end in the
+                   // next one
+  };
+
+  // Constructor for a MultiFileReader. Opens the first file, and starts
+  // opening the second one.
+  //
+  // Arguments:
+  // - fnames: the names of the files to read, in order
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  //   NOTE: delims is an optional arguement and is by default
+  //   set to white space characters
+  // - join: how tokens and lines are joined between files
+  MultiFileReader(const std::vector<std::string>& fnames,
+                  const std::string& delims = "\r\n\t ",
+                  JoinMode join = JoinMode::kSeparate);
+
+  // Constructor for a MultiFileReader whose delimiters are strings
+  // instead of single characters, as for the BufferedFileReader
+  // constructor taking a vector of delimiters.
+  // With JoinMode::kConcatenate, a delimiter string that is split
+  // between the end of one file and the start of the next is not found.
+  //
+  // Arguments:
+  // - fnames: the names of the files to read, in order
+  // - delims: the delimiter strings used for reading tokens
+  // - join: how tokens and lines are joined between files
+  MultiFileReader(const std::vector<std::string>& fnames,
+                  const std::vector<std::string>& delims,
+                  JoinMode join = JoinMode::kSeparate);
+
+  // Constructor for a MultiFileReader whose delimiters are fixed at
+  // compile time, e.g. MultiFileReader(fnames, Delims<',', '\n'>{}).
+  //
+  // Arguments:
+  // - fnames: the names of the files to read, in order
+  // - delims: the set of delimiters used for reading tokens
+  // - join: how tokens and lines are joined between files
+  template <char... Cs>
+  MultiFileReader(const std::vector<std::string>& fnames,
+                  Delims<Cs...> /* delims */,
+                  JoinMode join = JoinMode::kSeparate)
+      : MultiFileReader(fnames, join, [](const std::string& fname) {
+          return std::make_unique<BufferedFileReader>(fname, Delims<Cs...>{});
+        }) {}
+
+  // Destructor for a MultiFileReader. Closes the file being read and
+  // waits for the one being opened.
+  //
+  // Arguments: None
+  ~MultiFileReader() = default;
+
+  // Gets the next character, moving on to the next file at the end of
+  // each file.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the next character
+  // - EOF at the end of the last file
+  char get_char();
+
+  // Gets the next token, as BufferedFileReader::get_token() does.
+  // With JoinMode::kSeparate, the end of a file also ends a token.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the next token
+  // - nullopt at the end of the last file
+  std::optional<std::string> get_token();
+
+  // Gets the tokens of the next line, as BufferedFileReader::get_line()
+  // does. With JoinMode::kSeparate, the end of a file also ends a line,
+  // so the last line of a file is returned even if it has no newline.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the vector of tokens of the line
+  // - nullopt at the end of the last file
+  std::optional<std::vector<std::string>> get_line();
+
+  // Returns the index in the list of files of the file being read, or
+  // the number of files once they have all been read.
+  //
+  // Arguments: None
+  size_t file_index() const { return index_; }
+
+  // Returns whether or not there may be more to read
+  // (false once the end of the last file has been reached)
+  //
+  // Arguments: None
+  bool good() const { return current_ != nullptr; }
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  MultiFileReader(const MultiFileReader& other) = delete;
+  MultiFileReader& operator=(const MultiFileReader& other) = delete;
+
+ private:
+  // Opens the reader for one of the files
+  using Opener =
+      std::function<std::unique_ptr<BufferedFileReader>(const std::string&)>;
+
+  // Constructor shared by the public ones, reading each file with the
+  // reader made by open.
+  MultiFileReader(const std::vector<std::string>& fnames,
+                  JoinMode join,
+                  Opener open);
+
+  // Returns the unread bytes in the buffer of the current file, moving
+  // on to the next file first if there are none. An empty view at the
+  // end of the last file.
+  std::string_view peek();
+
+  // Moves on to the next file, which was opened in the background,
+  // and starts opening the one after it. Sets current_ to nullptr
+  // after the last file.
+  void next_file();
+
+  // Starts opening fnames_[index] on another thread
+  void prefetch(size_t index);
+
+  // fields
+  std::vector<std::string> fnames_;  // the files to read, in order
+  Opener open_;                      // makes the reader for each file
+  JoinMode join_;                    // how files are joined
+
+  size_t index_ = 0;                             // index of current_
+  std::unique_ptr<BufferedFileReader> current_;  // the file being read
+
+  // The reader of the file after current_, being opened on another
+  // thread. Not valid() after the last file.
+  std::future<std::unique_ptr<BufferedFileReader>> next_;
+};
+
+#endif  // MULTIFILEREADER_HPP_
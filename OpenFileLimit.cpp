@@ -0,0 +1,54 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <algorithm>
+
+#include "BufferedFileReader.hpp"
+#include "OpenFileLimit.hpp"
+using namespace std;
+
+OpenFileLimit::OpenFileLimit(size_t max_open)
+    : max_open_(max<size_t>(max_open, 1)) {
+  open_.reserve(max_open_);
+}
+
+void OpenFileLimit::make_room(const BufferedFileReader* opening) {
+  while (open_.size() >= max_open_) {
+    BufferedFileReader* oldest = nullptr;
+    for (BufferedFileReader* reader : open_) {
+      if (reader != opening && reader->can_park() &&
+          (oldest == nullptr || reader->last_used_ < oldest->last_used_)) {
+        oldest = reader;
+      }
+    }
+    if (oldest == nullptr) {
+      return;  // nothing can be closed, go over the limit
+    }
+    oldest->park();  // calls closed(oldest)
+    num_evicted_++;
+  }
+}
+
+void OpenFileLimit::opened(BufferedFileReader* reader) {
+  open_.push_back(reader);
+}
+
+void OpenFileLimit::closed(const BufferedFileReader* reader) {
+  auto it = find(open_.begin(), open_.end(), reader);
+  if (it != open_.end()) {
+    *it = open_.back();
+    open_.pop_back();
+  }
+}
+
+void OpenFileLimit::moved(BufferedFileReader* from, BufferedFileReader* to) {
+  replace(open_.begin(), open_.end(), from, to);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef OPENFILELIMIT_HPP_
+#define OPENFILELIMIT_HPP_
+
+#include <cstdint>
+#include <vector>
+
+class BufferedFileReader;
+
+///////////////////////////////////////////////////////////////////////////////
+// An OpenFileLimit caps how many file descriptors a group of lazily
+// opened BufferedFileReaders keep open at once (see
+// BufferedFileReader::Lazy).
+//
+// When a reader of the group needs to open its file and the group is at
+// the limit, the reader that was used least recently has its file
+// closed. It keeps its buffer and its offset, and opens the file again,
+// from that offset, the next time it needs more of it. So thousands of
+// readers can be merged or scheduled with only a few files open.
+//
+// Readers that can't be reopened where they left off (compressed files,
+// pipes, readers in follow mode) are never closed early, so the limit
+// may be exceeded while there are more of them open than it allows.
+//
+// The readers of a group must all be used from the same thread, and
+// the OpenFileLimit must outlive them.
+///////////////////////////////////////////////////////////////////////////////
+class OpenFileLimit {
+ public:
+  // Constructor for an OpenFileLimit.
+  //
+  // Arguments:
+  // - max_open: the most files the readers may have open at once
+  //   (at least one)
+  explicit OpenFileLimit(size_t max_open);
+
+  // Returns the number of files the readers have open.
+  size_t num_open() const { return open_.size(); }
+
+  // Returns the most files the readers may have open at once.
+  size_t max_open() const { return max_open_; }
+
+  // Returns the number of times a reader's file was closed early to
+  // make room for another reader's.
+  uint64_t num_evicted() const { return num_evicted_; }
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  OpenFileLimit(const OpenFileLimit& other) = delete;
+  OpenFileLimit& operator=(const OpenFileLimit& other) = delete;
+
+ private:
+  friend class BufferedFileReader;
+
+  // Called by a reader that is about to open its file. If the limit has
+  // been reached, closes the file of the least recently used reader
+  // that can be reopened later (never the one opening).
+  void make_room(const BufferedFileReader* opening);
+
+  // Called by a reader once it has opened its file
+  void opened(BufferedFileReader* reader);
+
+  // Called by a reader once it has closed its file
+  void closed(const BufferedFileReader* reader);
+
+  // Called when a reader with an open file is moved to a new address
+  void moved(BufferedFileReader* from, BufferedFileReader* to);
+
+  // Returns the time of a use of a file, for picking which to close
+  uint64_t tick() { return ++clock_; }
+
+  // fields
+  size_t max_open_;                        // the limit
+  std::vector<BufferedFileReader*> open_;  // readers with an open file
+  uint64_t clock_ = 0;                     // the last value of tick()
+  uint64_t num_evicted_ = 0;               // files closed by make_room()
+};
+
+#endif  // OPENFILELIMIT_HPP_
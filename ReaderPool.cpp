@@ -0,0 +1,64 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <utility>
+
+#include "ReaderPool.hpp"
+using namespace std;
+
+ReaderPool::ReaderPool(const string& delims, size_t max_idle)
+    : delims_(delims), max_idle_(max_idle) {
+  idle_.reserve(max_idle_);
+}
+
+BufferedFileReader ReaderPool::acquire(const string& fname) {
+  unique_lock<mutex> guard(lock_);
+  if (idle_.empty()) {
+    num_created_++;
+    guard.unlock();
+    return BufferedFileReader(fname, delims_);
+  }
+  BufferedFileReader reader = std::move(idle_.back());
+  idle_.pop_back();
+  num_reused_++;
+  guard.unlock();
+
+  reader.open_file(fname);
+  return reader;
+}
+
+void ReaderPool::release(BufferedFileReader&& reader) {
+  reader.close_file();
+  reader.set_follow(false);
+  reader.set_drop_behind(false);
+  reader.advise(AccessPattern::kNormal);
+  BufferedFileReader to_destroy = std::move(reader);
+  lock_guard<mutex> guard(lock_);
+  if (idle_.size() < max_idle_) {
+    idle_.push_back(std::move(to_destroy));
+  }
+  // otherwise to_destroy is destroyed once the lock is let go
+}
+
+size_t ReaderPool::num_idle() const {
+  lock_guard<mutex> guard(lock_);
+  return idle_.size();
+}
+
+uint64_t ReaderPool::num_created() const {
+  lock_guard<mutex> guard(lock_);
+  return num_created_;
+}
+
+uint64_t ReaderPool::num_reused() const {
+  lock_guard<mutex> guard(lock_);
+  return num_reused_;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef READERPOOL_HPP_
+#define READERPOOL_HPP_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "BufferedFileReader.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// A ReaderPool hands out BufferedFileReaders and takes them back when
+// they are done, to be reused for the next file.
+//
+// A reader that is given back keeps its buffer and its delimiters, so
+// opening the next file with it only costs the open() itself. Code that
+// reads many small files one after another gets to reuse the same few
+// readers over and over instead of allocating a new one for each file.
+// The pool can be shared between threads.
+///////////////////////////////////////////////////////////////////////////////
+class ReaderPool {
+ public:
+  // Constructor for an empty ReaderPool.
+  //
+  // Arguments:
+  // - delims: the delimiters of every reader from this pool.
+  //   NOTE: delims is an optional arguement and is by default
+  //   set to white space characters
+  // - max_idle: the most readers to keep for reuse. Readers given back
+  //   when the pool already has that many are destroyed.
+  ReaderPool(const std::string& delims = "\r\n\t ", size_t max_idle = 64);
+
+  // Returns a reader with the specified file open, reusing one that was
+  // given back if there is one.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  //
+  // Returns:
+  // - the reader. Check good() to see if the file was opened.
+  BufferedFileReader acquire(const std::string& fname);
+
+  // Gives a reader back to the pool to be reused, closing its file.
+  // Follow mode, drop-behind and access advice are turned off.
+  //
+  // Arguments:
+  // - reader: the reader, which should have come from acquire()
+  void release(BufferedFileReader&& reader);
+
+  // Returns the number of readers waiting to be reused.
+  size_t num_idle() const;
+
+  // Returns the number of readers the pool has had to create.
+  uint64_t num_created() const;
+
+  // Returns the number of times acquire() reused a reader.
+  uint64_t num_reused() const;
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  ReaderPool(const ReaderPool& other) = delete;
+  ReaderPool& operator=(const ReaderPool& other) = delete;
+
+ private:
+  std::string delims_;  // the delimiters of every reader
+  size_t max_idle_;     // the most readers to keep in idle_
+
+  mutable std::mutex lock_;              // guards the fields below it
+  std::vector<BufferedFileReader> idle_;  // readers ready to be reused
+  uint64_t num_created_ = 0;             // readers created by acquire()
+  uint64_t num_reused_ = 0;              // readers reused by acquire()
+};
+
+#endif  // READERPOOL_HPP_
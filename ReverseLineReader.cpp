@@ -0,0 +1,157 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "ReverseLineReader.hpp"
+using namespace std;
+
+ReverseLineReader::ReverseLineReader(const string& fname, const string& delims)
+    : fd_(open(fname.c_str(), O_RDONLY)),
+      delim_table_(make_delim_table(delims)),
+      window_pos_(0),
+      window_start_(0),
+      line_end_(0),
+      line_start_(0),
+      good_(false) {
+  struct stat st {};
+  if (fd_ == -1 || fstat(fd_, &st) == -1) {
+    return;
+  }
+  window_start_ = st.st_size;
+  line_end_ = st.st_size;
+  line_start_ = st.st_size;
+  good_ = st.st_size > 0;
+
+  // a '\n' at the end of the file ends the last line,
+  // rather than starting an empty one after it
+  if (good_ && read_chunk() &&
+      window_data()[line_end_ - window_start_ - 1] == '\n') {
+    line_end_--;
+  }
+}
+
+ReverseLineReader::~ReverseLineReader() {
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool ReverseLineReader::read_chunk() {
+  if (window_start_ == 0) {
+    return false;
+  }
+  off_t chunk_start = max<off_t>(0, window_start_ - CHUNK_SIZE);
+  size_t chunk_size = window_start_ - chunk_start;
+
+  if (window_pos_ < chunk_size) {
+    // only the part of the window up to line_end_ is still needed. It
+    // moves to the back of a buffer twice the size it needs to be, so
+    // a line of any length is only moved a few times in all
+    size_t keep = line_end_ - window_start_;
+    string bigger(2 * (keep + chunk_size), '\0');
+    memcpy(bigger.data() + bigger.size() - keep, window_data(), keep);
+    window_ = std::move(bigger);
+    window_pos_ = window_.size() - keep;
+  }
+
+  char* chunk = window_.data() + window_pos_ - chunk_size;
+  size_t total = 0;
+  while (total < chunk_size) {
+    ssize_t result =
+        pread(fd_, chunk + total, chunk_size - total, chunk_start + total);
+    if (result == -1 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      return false;  // error, or the file shrank
+    }
+    total += result;
+  }
+  window_pos_ -= chunk_size;
+  window_start_ = chunk_start;
+  return true;
+}
+
+optional<string_view> ReverseLineReader::get_raw_line() {
+  if (fd_ == -1 || !good_) {
+    good_ = false;
+    return nullopt;
+  }
+
+  // find the '\n' before the line, reading further back as needed
+  const void* newline = nullptr;
+  off_t searched = line_end_;  // everything from here on has no '\n'
+  while (true) {
+    size_t len = searched - window_start_;
+    newline = len == 0 ? nullptr : memrchr(window_data(), '\n', len);
+    if (newline != nullptr) {
+      break;
+    }
+    searched = window_start_;
+    if (!read_chunk()) {
+      break;
+    }
+  }
+
+  line_start_ = newline == nullptr
+                    ? window_start_
+                    : window_start_ + (static_cast<const char*>(newline) -
+                                       window_data() + 1);
+  string_view line(window_data() + (line_start_ - window_start_),
+                   line_end_ - line_start_);
+
+  if (newline == nullptr) {
+    good_ = false;  // that was the first line of the file
+  } else {
+    line_end_ = line_start_ - 1;
+  }
+  return line;
+}
+
+optional<vector<string>> ReverseLineReader::get_line() {
+  optional<string_view> raw = get_raw_line();
+  if (!raw.has_value()) {
+    return nullopt;
+  }
+
+  // every delimiter ends a token, and so does the end of the line
+  vector<string> line;
+  string_view rest = raw.value();
+  size_t start = 0;
+  for (size_t i = 0; i < rest.size(); i++) {
+    if (delim_table_[static_cast<unsigned char>(rest[i])]) {
+      line.emplace_back(rest.substr(start, i - start));
+      start = i + 1;
+    }
+  }
+  line.emplace_back(rest.substr(start));
+  return line;
+}
+
+off_t ReverseLineReader::tell() const {
+  if (fd_ == -1) {
+    return -1;
+  }
+  return line_start_;
+}
+
+bool ReverseLineReader::good() const {
+  return good_;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef REVERSELINEREADER_HPP_
+#define REVERSELINEREADER_HPP_
+
+#include <sys/types.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Delims.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// A ReverseLineReader reads the lines of a file from the last one to
+// the first, like tail.
+//
+// The file is read backwards from the end in large chunks, so getting
+// the last few lines of a huge file only reads the end of it. Lines are
+// split into tokens with the same rules as BufferedFileReader::get_line(),
+// except that the last token of a last line with no '\n' is kept.
+///////////////////////////////////////////////////////////////////////////////
+class ReverseLineReader {
+ public:
+  // Constructor for a ReverseLineReader. Should open the
+  // file and do whatever is necesary to "set-up" the object.
+  // After construction, reading from the file should start
+  // at the last line of the file.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  //   NOTE: delims is an optional arguement and is by default
+  //   set to white space characters
+  ReverseLineReader(const std::string& fname,
+                    const std::string& delims = "\r\n\t ");
+
+  // Destructor for a ReverseLineReader. Closes the file.
+  //
+  // Arguments: None
+  ~ReverseLineReader();
+
+  // Reads the line before the one that was read last (or the last line
+  // of the file on the first call) and returns its tokens.
+  // A '\n' at the very end of the file does not start a new line.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the vector of tokens of the line, split like
+  //   BufferedFileReader::get_line() splits it. The one difference is
+  //   a last line with no '\n' after it: for "a b\nc d", get_line()
+  //   drops the "d" that the end of the file cuts short and returns
+  //   {c}, but this returns {c, d}.
+  // - nullopt if the first line of the file has already been read,
+  //   or the file is not open
+  std::optional<std::vector<std::string>> get_line();
+
+  // Same as get_line(), but returns the line as it is in the file,
+  // without splitting it into tokens or the '\n' at its end.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the line, which is only valid until the next call to read a line
+  // - nullopt if the first line of the file has already been read,
+  //   or the file is not open
+  std::optional<std::string_view> get_raw_line();
+
+  // Returns the offset in the file at which the last line read starts,
+  // or the size of the file if no line has been read yet.
+  // -1 if there is no open file.
+  //
+  // Arguments: None
+  off_t tell() const;
+
+  // Returns whether or not there are lines left to read
+  // (i.e. the first line of the file has not been read yet)
+  //
+  // Arguments: None
+  bool good() const;
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  ReverseLineReader(const ReverseLineReader& other) = delete;
+  ReverseLineReader& operator=(const ReverseLineReader& other) = delete;
+
+ private:
+  // Constants
+  static constexpr off_t CHUNK_SIZE = 65536;  // bytes read at a time
+
+  // Reads the chunk of the file before window_start_ into the space in
+  // front of the window, making more space first if needed. Returns
+  // false if already at the start of the file or the read failed.
+  bool read_chunk();
+
+  // Returns where the byte at window_start_ is
+  const char* window_data() const { return window_.data() + window_pos_; }
+
+  // fields
+  int fd_;                  // The File Descriptor of the file
+  DelimTable delim_table_;  // the delimiters used for reading tokens
+  std::string window_;      // bytes of the file from window_start_, at
+                            // the back so chunks can go in front of them
+  size_t window_pos_;       // index in window_ of the byte at window_start_
+  off_t window_start_;      // offset of the start of the window in the file
+  off_t line_end_;          // offset just past the next line to read
+                            // (where its '\n' is)
+  off_t line_start_;        // offset of the start of the last line read
+  bool good_;               // Whether or not there are lines left to read
+};
+
+#endif  // REVERSELINEREADER_HPP_
@@ -0,0 +1,149 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+
+#include "SharedBufferedFileReader.hpp"
+using namespace std;
+
+SharedBufferedFileReader::SharedBufferedFileReader(const string& fname,
+                                                   const string& delims,
+                                                   bool huge_pages)
+    : mapping_(nullptr), open_(false), delim_table_(make_delim_table(delims)) {
+  int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  open_ = true;
+  struct stat st {};
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      mapping_ = mapping;
+      if (huge_pages) {
+        madvise(mapping, st.st_size, MADV_HUGEPAGE);
+      }
+      data_ = string_view(static_cast<const char*>(mapping), st.st_size);
+      close(fd);
+      return;
+    }
+  }
+
+  // can't be mapped (a pipe, or an empty file): read it all instead
+  array<char, 65536> buf{};
+  while (true) {
+    ssize_t result = read(fd, buf.data(), buf.size());
+    if (result == -1 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      break;
+    }
+    copy_.append(buf.data(), result);
+  }
+  close(fd);
+  data_ = copy_;
+}
+
+SharedBufferedFileReader::~SharedBufferedFileReader() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, data_.size());
+  }
+}
+
+template <typename IsEnd>
+optional<string_view> SharedBufferedFileReader::claim(IsEnd is_end) {
+  // the contents never change, so only the cursor is contended, and
+  // relaxed ordering is enough
+  size_t pos = cursor_.load(memory_order_relaxed);
+  while (pos < data_.size()) {
+    size_t end = pos;
+    while (end < data_.size() && !is_end(data_[end])) {
+      end++;
+    }
+    if (end < data_.size()) {
+      end++;  // the char that ended it is claimed too
+    }
+    // fails, updating pos, if another thread claimed from pos first
+    if (cursor_.compare_exchange_weak(pos, end, memory_order_relaxed)) {
+      return data_.substr(pos, end - pos);
+    }
+  }
+  return nullopt;
+}
+
+optional<string_view> SharedBufferedFileReader::get_token_view() {
+  optional<string_view> token =
+      claim([this](char c) { return is_delim(c); });
+  if (token.has_value() && !token->empty() && is_delim(token->back())) {
+    token->remove_suffix(1);
+  }
+  return token;
+}
+
+optional<string> SharedBufferedFileReader::get_token() {
+  optional<string_view> token = get_token_view();
+  if (!token.has_value()) {
+    return nullopt;
+  }
+  return string(token.value());
+}
+
+optional<vector<string>> SharedBufferedFileReader::get_line() {
+  optional<string_view> claimed = claim([](char c) { return c == '\n'; });
+  if (!claimed.has_value()) {
+    return nullopt;
+  }
+  string_view rest = claimed.value();
+  vector<string> line;
+  size_t start = 0;
+  for (size_t i = 0; i < rest.size(); i++) {
+    if (rest[i] == '\n' || is_delim(rest[i])) {
+      line.emplace_back(rest.substr(start, i - start));
+      start = i + 1;
+    }
+  }
+  if (start < rest.size()) {
+    // the last line of the file, with no newline after it
+    line.emplace_back(rest.substr(start));
+  }
+  return line;
+}
+
+off_t SharedBufferedFileReader::tell() const {
+  if (!open_) {
+    return -1;
+  }
+  return static_cast<off_t>(cursor_.load(memory_order_relaxed));
+}
+
+bool SharedBufferedFileReader::advise(AccessPattern pattern) {
+  if (mapping_ == nullptr) {
+    return false;
+  }
+  int advice = MADV_NORMAL;
+  if (pattern == AccessPattern::kSequential) {
+    advice = MADV_SEQUENTIAL;
+  } else if (pattern == AccessPattern::kRandom) {
+    advice = MADV_RANDOM;
+  }
+  return madvise(mapping_, data_.size(), advice) == 0;
+}
+
+bool SharedBufferedFileReader::good() const {
+  return open_ && cursor_.load(memory_order_relaxed) < data_.size();
+}
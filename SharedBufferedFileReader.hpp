@@ -0,0 +1,146 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef SHAREDBUFFEREDFILEREADER_HPP_
+#define SHAREDBUFFEREDFILEREADER_HPP_
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AccessPattern.hpp"
+#include "Delims.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// A SharedBufferedFileReader is a reader that many threads can read
+// tokens and lines from at the same time.
+//
+// The whole file is mapped into memory (or read into memory, if it can't
+// be mapped, e.g. a pipe), and the only thing the threads share is the
+// offset of the first unread byte. A call finds the end of the next token
+// or line from that offset, then claims the bytes up to it by moving the
+// offset there with a compare-and-swap. If another thread moved it first,
+// the call tries again from the new offset. So every token or line goes
+// to exactly one thread, whole, and threads never wait on a lock.
+//
+// Tokens and lines are split with the same rules as BufferedFileReader,
+// except that the last line is returned even if it has no '\n'.
+///////////////////////////////////////////////////////////////////////////////
+class SharedBufferedFileReader {
+ public:
+  // Constructor for a SharedBufferedFileReader. Opens and maps the file.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  //   NOTE: delims is an optional arguement and is by default
+  //   set to white space characters
+  // - huge_pages: whether to ask for the mapping to be backed by
+  //   transparent huge pages. Only has an effect on kernels that can put
+  //   files in huge pages (CONFIG_READ_ONLY_THP_FOR_FS, or tmpfs with
+  //   huge pages on); it is harmless elsewhere.
+  SharedBufferedFileReader(const std::string& fname,
+                           const std::string& delims = "\r\n\t ",
+                           bool huge_pages = false);
+
+  // Destructor for a SharedBufferedFileReader. Unmaps the file.
+  // No other thread may be using the reader.
+  //
+  // Arguments: None
+  ~SharedBufferedFileReader();
+
+  // Gets the next token, as BufferedFileReader::get_token() does.
+  // Safe to call from many threads at once.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the next token
+  // - nullopt if at the end of the file or if the file is not open
+  std::optional<std::string> get_token();
+
+  // Same as get_token(), but without copying the token: the view points
+  // into the file's contents and stays valid as long as the reader.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - a view of the next token
+  // - nullopt if at the end of the file or if the file is not open
+  std::optional<std::string_view> get_token_view();
+
+  // Gets the tokens of the next line, as BufferedFileReader::get_line()
+  // does. Safe to call from many threads at once.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the vector of tokens of the line
+  // - nullopt if at the end of the file or if the file is not open
+  std::optional<std::vector<std::string>> get_line();
+
+  // Returns the offset of the first byte no thread has claimed yet,
+  // or -1 if there is no open file.
+  //
+  // Arguments: None
+  off_t tell() const;
+
+  // Tells the kernel how the file's mapping is going to be read, with
+  // madvise(). Safe to call while other threads are reading.
+  //
+  // Arguments:
+  // - pattern: how the file is going to be read
+  //
+  // Returns:
+  // - true if the kernel was told
+  // - false if the file was not mapped (it was read into memory
+  //   instead, so there is nothing to advise)
+  bool advise(AccessPattern pattern);
+
+  // Returns whether or not there is anything left to claim.
+  //
+  // Arguments: None
+  bool good() const;
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  SharedBufferedFileReader(const SharedBufferedFileReader& other) = delete;
+  SharedBufferedFileReader& operator=(const SharedBufferedFileReader& other) =
+      delete;
+
+ private:
+  // Claims the bytes from the cursor up to and including the first
+  // char that ends the token or line (is_end(c) is true), or up to the
+  // end of the file. Returns the claimed bytes, or nullopt if the
+  // cursor was at the end of the file.
+  template <typename IsEnd>
+  std::optional<std::string_view> claim(IsEnd is_end);
+
+  bool is_delim(char to_check) const {
+    return delim_table_[static_cast<unsigned char>(to_check)];
+  }
+
+  // fields
+  std::string_view data_;   // the contents of the file
+  void* mapping_;           // the mmap()ed file, or nullptr
+  std::string copy_;        // the contents, if they could not be mapped
+  bool open_;               // whether the file was opened
+  DelimTable delim_table_;  // the delimiters used for reading tokens
+  std::atomic<size_t> cursor_{0};  // offset of the first unclaimed byte
+};
+
+#endif  // SHAREDBUFFEREDFILEREADER_HPP_
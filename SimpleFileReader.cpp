@@ -12,10 +12,67 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <algorithm>
 #include <array>
+#include <utility>
 static constexpr uint64_t BUF_SIZE = 100000;
+// the most parts handed to one readv() or preadv() call
+static constexpr size_t MAX_IOVECS = 64;
 using namespace std;
+
+// helper functions
+
+// Reads into parts, in order, with read_fn(iov, count, done), where done
+// is the number of bytes read so far, until every part is full or
+// read_fn returns 0. read_fn is a readv() or preadv() call, and is
+// called again after a short read (e.g. from a pipe). Returns the
+// number of bytes read, or -1 if read_fn failed before reading any.
+template <typename ReadFn>
+static ssize_t scatter_read(span<const span<char>> parts, ReadFn read_fn) {
+  size_t part = 0;       // the first part that isn't full
+  size_t part_done = 0;  // the bytes already read into parts[part]
+  size_t total = 0;
+  array<iovec, MAX_IOVECS> iov{};
+  while (true) {
+    while (part < parts.size() && part_done == parts[part].size()) {
+      part++;
+      part_done = 0;
+    }
+    if (part == parts.size()) {
+      break;
+    }
+    size_t count = 0;
+    for (size_t i = part; i < parts.size() && count < iov.size(); i++) {
+      size_t skip = i == part ? part_done : 0;
+      iov[count++] = {parts[i].data() + skip, parts[i].size() - skip};
+    }
+    ssize_t read_bytes = read_fn(iov.data(), static_cast<int>(count), total);
+    if (read_bytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return total > 0 ? static_cast<ssize_t>(total) : -1;
+    }
+    if (read_bytes == 0) {  // end of file
+      break;
+    }
+    total += read_bytes;
+    // move past the parts that were filled
+    for (size_t left = read_bytes; left > 0;) {
+      size_t used = min(parts[part].size() - part_done, left);
+      part_done += used;
+      left -= used;
+      if (part_done == parts[part].size()) {
+        part++;
+        part_done = 0;
+      }
+    }
+  }
+  return static_cast<ssize_t>(total);
+}
+
 SimpleFileReader::SimpleFileReader(const std::string& fname)
     : fd_(open(fname.c_str(), O_RDONLY)) {
   // fd_ = open(fname.c_str(), O_RDONLY);
@@ -27,6 +84,41 @@ SimpleFileReader::SimpleFileReader(const std::string& fname)
   good_ = true;
 }
 
+SimpleFileReader::SimpleFileReader(int fd) : fd_(fd) {
+  if (fd_ < 0) {
+    fd_ = -1;
+    this->good_ = false;
+    return;
+  }
+  // pipes, sockets and terminals can't seek, so their offsets
+  // are counted from wherever the reader started reading
+  off_t start = lseek(fd_, 0, SEEK_CUR);
+  seekable_ = start != -1;
+  pos_ = seekable_ ? start : 0;
+  good_ = true;
+}
+
+SimpleFileReader::SimpleFileReader(SimpleFileReader&& other) noexcept
+    : fd_(exchange(other.fd_, -1)),
+      good_(exchange(other.good_, false)),
+      pos_(exchange(other.pos_, 0)),
+      seekable_(other.seekable_) {}
+
+SimpleFileReader& SimpleFileReader::operator=(
+    SimpleFileReader&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  fd_ = exchange(other.fd_, -1);
+  good_ = exchange(other.good_, false);
+  pos_ = exchange(other.pos_, 0);
+  seekable_ = other.seekable_;
+  return *this;
+}
+
 SimpleFileReader::~SimpleFileReader() {
   if (this->fd_ >= 0) {
     close(this->fd_);
@@ -45,7 +137,8 @@ void SimpleFileReader::open_file(const std::string& fname) {
     good_ = false;
     return;
   }
-  lseek(fd_, 0, SEEK_SET);
+  seekable_ = lseek(fd_, 0, SEEK_SET) != -1;
+  pos_ = 0;
   good_ = true;
 }
 
@@ -68,6 +161,9 @@ char SimpleFileReader::get_char() {
       good_ = false;
       return EOF;
     }
+    if (read_bytes == 1) {
+      pos_++;
+    }
   }
   good_ = true;
   return temp;
@@ -86,13 +182,14 @@ optional<string> SimpleFileReader::get_chars(size_t n) {
   ssize_t bytesRead = 0;
   while (totalRead < n) {
     bytesRead = read(fd_, buf.data() + totalRead, n - totalRead);
-    totalRead += bytesRead;
     if (bytesRead < 0) {
       if (errno != EINTR) {
         good_ = false;
         return nullopt;
       }
+      continue;
     }
+    totalRead += bytesRead;
     if (bytesRead == 0) {
       good_ = false;
       //   if (totalRead == 0) {
@@ -106,21 +203,65 @@ optional<string> SimpleFileReader::get_chars(size_t n) {
   // final_result = result;
   // delete[] result;
   // return final_result;
+  pos_ += static_cast<off_t>(totalRead);
   return std::string(buf.begin(), buf.begin() + totalRead);
 }
 
-int SimpleFileReader::tell() const {
+ssize_t SimpleFileReader::read_into(span<const span<char>> parts) {
+  if (fd_ < 0) {
+    good_ = false;
+    return -1;
+  }
+  size_t wanted = 0;
+  for (span<char> part : parts) {
+    wanted += part.size();
+  }
+  auto read_next = [this](const iovec* iov, int count, size_t) {
+    return readv(fd_, iov, count);
+  };
+  ssize_t total = scatter_read(parts, read_next);
+  if (total < 0) {
+    good_ = false;
+    return -1;
+  }
+  pos_ += total;
+  // a short read means the end of the file was reached
+  good_ = static_cast<size_t>(total) == wanted;
+  return total;
+}
+
+ssize_t SimpleFileReader::pread_into(span<const span<char>> parts,
+                                     off_t offset) const {
+  if (fd_ < 0 || !seekable_ || offset < 0) {
+    return -1;
+  }
+  auto read_at = [this, offset](const iovec* iov, int count, size_t done) {
+    return preadv(fd_, iov, count, offset + static_cast<off_t>(done));
+  };
+  return scatter_read(parts, read_at);
+}
+
+off_t SimpleFileReader::tell() const {
   if (this->fd_ == -1) {
     return -1;
   }
-  int pos = (int)lseek(this->fd_, 0, SEEK_CUR);
-  return pos;
+  // counted as we read, so it also works for pipes
+  return pos_;
 }
 
-void SimpleFileReader::rewind() {
+bool SimpleFileReader::rewind() {
+  if (fd_ < 0 || !seekable_) {
+    return false;
+  }
   good_ = true;
   lseek(this->fd_, 0, SEEK_SET);
+  pos_ = 0;
+  return true;
 }
 bool SimpleFileReader::good() const {
   return good_;
+}
+
+bool SimpleFileReader::seekable() const {
+  return fd_ >= 0 && seekable_;
 }
\ No newline at end of file
@@ -12,7 +12,10 @@
 #ifndef SIMPLEFILEREADER_HPP_
 #define SIMPLEFILEREADER_HPP_
 
+#include <sys/types.h>
+
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -35,6 +38,18 @@ class SimpleFileReader {
   // - fname: The name of the file to be read
   SimpleFileReader(const std::string& fname);
 
+  // Constructor for a SimpleFileReader that reads from a file
+  // descriptor that is already open, such as STDIN_FILENO, the read end
+  // of a pipe, or a socket. Reading starts wherever the descriptor is.
+  // Descriptors that can't seek are supported: tell() counts the bytes
+  // read since construction, and rewind() reports failure.
+  //
+  // Arguments:
+  // - fd: the file descriptor to read from. The SimpleFileReader
+  //   takes ownership of it and closes it when done (dup() it first
+  //   to keep using it, e.g. for stdin).
+  SimpleFileReader(int fd);
+
   // Destructor for a SimpleFileReader. Should clean up
   // any allocated resources such as memory or open files.
   //
@@ -81,6 +96,38 @@ class SimpleFileReader {
   //   at the end of the file.
   std::optional<std::string> get_chars(size_t n);
 
+  // Reads the next bytes of the file straight into the caller's
+  // buffers, filling each part in order, with readv(). For reading a
+  // record with a fixed layout (e.g. a header, a body and a trailer)
+  // in one system call, without a string for each part.
+  //
+  // Arguments:
+  // - parts: the buffers to fill, in the order the bytes are in the
+  //   file. Every part is filled before any byte goes into the next.
+  //
+  // Returns:
+  // - the number of bytes read. Fewer than the total size of parts
+  //   if the end of the file is reached first, which makes the reader
+  //   no longer good().
+  // - -1 if there is no file open, or nothing could be read
+  ssize_t read_into(std::span<const std::span<char>> parts);
+
+  // Same as read_into(), but reads from the given offset in the file
+  // with preadv(), without moving the reader or changing good().
+  // Many threads may call it at once.
+  //
+  // Arguments:
+  // - parts: the buffers to fill, in order
+  // - offset: the offset in the file of the first byte to read
+  //
+  // Returns:
+  // - the number of bytes read, fewer than the total size of parts if
+  //   the file ends first
+  // - -1 if there is no file open, the file can't seek, or nothing
+  //   could be read
+  ssize_t pread_into(std::span<const std::span<char>> parts,
+                     off_t offset) const;
+
   // Returns the current position the user is in to the file.
   //
   // Arguments: None
@@ -91,14 +138,19 @@ class SimpleFileReader {
   //   the start of the file, returns 0. If the user has read 2
   //   characters, return 2. etc.).
   // - -1 if there is no open file
-  int tell() const;
+  off_t tell() const;
 
   // Resets the file to start reading from the beginning
   // of the file that is currently open.
-  // Undefined behaviour if there is no file open currently.
+  // Does nothing if there is no file open currently,
+  // or if the file can't seek (e.g. a pipe).
   //
   // Arguments: None
-  void rewind();
+  //
+  // Returns:
+  // - true if the reader is back at the beginning of the file
+  // - false if there is no file open or the file can't seek
+  bool rewind();
 
   // Returns whether or not the file is available for reading
   // (e.g. if the file is open and not at the end of file)
@@ -114,19 +166,39 @@ class SimpleFileReader {
   // - true otherwise
   bool good() const;
 
+  // Returns whether or not the open file supports rewind().
+  // Regular files do; pipes, sockets and terminals don't.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - true if there is a file open and it can seek
+  // - false otherwise
+  bool seekable() const;
+
+  // Move constructor and move assignment for a SimpleFileReader.
+  // The open file and the position in it are handed over, leaving
+  // other with no file open. Move assignment closes the file this
+  // reader had open first.
+  //
+  // Arguments:
+  // - other: the reader to move from
+  SimpleFileReader(SimpleFileReader&& other) noexcept;
+  SimpleFileReader& operator=(SimpleFileReader&& other) noexcept;
+
   // Ignore These
   // If you want to know more, this is disabling the
   // copy constructor and the assignment operator.
   // These will be covered later in the class
   SimpleFileReader(const SimpleFileReader& other) = delete;
   SimpleFileReader& operator=(const SimpleFileReader& other) = delete;
-  SimpleFileReader(const SimpleFileReader&& other) = delete;
-  SimpleFileReader& operator=(const SimpleFileReader&& other) = delete;
 
  private:
   // fields
   int fd_;     // The File Descriptor that we use to manage our file.
   bool good_;  // Whether or not the reader is good to read
+  off_t pos_ = 0;          // The offset in the file we are at
+  bool seekable_ = true;   // Whether or not fd_ can seek
 };
 
 #endif  // SIMPLEFILE_READER_HPP_
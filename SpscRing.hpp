@@ -0,0 +1,178 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef SPSCRING_HPP_
+#define SPSCRING_HPP_
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// A SpscRing is a fixed size, lock-free queue between exactly one
+// producer thread and one consumer thread.
+//
+// The slots are allocated once and reused: the producer claim()s the next
+// free slot, fills it in place, and publish()es it; the consumer reads the
+// oldest published slot with front() and hands it back with pop(). Each
+// side only writes its own index, so no locks are needed. When the ring
+// is full the producer waits (backpressure), and when it is empty the
+// consumer waits, on the other side's index with std::atomic::wait.
+//
+// Either side can end the stream: the producer close()s it when it has
+// nothing more to publish, the consumer cancel()s it to stop early.
+///////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class SpscRing {
+ public:
+  // Constructor for a SpscRing.
+  //
+  // Arguments:
+  // - capacity: the number of slots, rounded up to a power of two
+  explicit SpscRing(size_t capacity)
+      : slots_(std::bit_ceil(capacity < 1 ? 1 : capacity)),
+        mask_(slots_.size() - 1) {}
+
+  // Producer: returns the next free slot to fill, or nullptr if the
+  // ring is full or was cancelled. Does not wait.
+  T* try_claim() {
+    size_t head = head_.load(std::memory_order_relaxed) & ~kEnded;
+    if (head - cached_tail_ > mask_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire) & ~kEnded;
+      if (head - cached_tail_ > mask_) {
+        return nullptr;
+      }
+    }
+    if ((tail_.load(std::memory_order_relaxed) & kEnded) != 0) {
+      return nullptr;
+    }
+    return &slots_[head & mask_];
+  }
+
+  // Producer: returns the next free slot to fill, waiting for the
+  // consumer to pop() one if the ring is full.
+  // Returns nullptr if the consumer cancel()ed the ring.
+  T* claim() {
+    while (true) {
+      T* slot = try_claim();
+      if (slot != nullptr) {
+        return slot;
+      }
+      size_t tail = tail_.load(std::memory_order_acquire);
+      if ((tail & kEnded) != 0) {
+        return nullptr;
+      }
+      size_t head = head_.load(std::memory_order_relaxed) & ~kEnded;
+      if (head - tail > mask_) {
+        tail_.wait(tail, std::memory_order_acquire);
+      }
+    }
+  }
+
+  // Producer: makes the slot returned by the last claim() visible to
+  // the consumer.
+  void publish() {
+    head_.fetch_add(1, std::memory_order_release);
+    head_.notify_one();
+  }
+
+  // Producer: marks the end of the stream. The consumer still gets
+  // every slot published before it.
+  void close() {
+    head_.fetch_or(kEnded, std::memory_order_release);
+    head_.notify_one();
+  }
+
+  // Consumer: returns the oldest published slot, or nullptr if there
+  // is none yet. Does not wait.
+  T* try_front() {
+    size_t tail = tail_.load(std::memory_order_relaxed) & ~kEnded;
+    if (tail == cached_head_) {
+      cached_head_ = head_.load(std::memory_order_acquire) & ~kEnded;
+      if (tail == cached_head_) {
+        return nullptr;
+      }
+    }
+    return &slots_[tail & mask_];
+  }
+
+  // Consumer: returns the oldest published slot, waiting for the
+  // producer to publish() one if the ring is empty.
+  // Returns nullptr once the ring is empty and close()d.
+  T* front() {
+    while (true) {
+      T* slot = try_front();
+      if (slot != nullptr) {
+        return slot;
+      }
+      size_t head = head_.load(std::memory_order_acquire);
+      if ((head & ~kEnded) != (tail_.load(std::memory_order_relaxed) &
+                               ~kEnded)) {
+        continue;
+      }
+      if ((head & kEnded) != 0) {
+        return nullptr;
+      }
+      head_.wait(head, std::memory_order_acquire);
+    }
+  }
+
+  // Consumer: hands the slot returned by front() back to the producer.
+  void pop() {
+    tail_.fetch_add(1, std::memory_order_release);
+    tail_.notify_one();
+  }
+
+  // Consumer: stops the stream early. The producer's next claim()
+  // returns nullptr.
+  void cancel() {
+    tail_.fetch_or(kEnded, std::memory_order_release);
+    tail_.notify_one();
+  }
+
+  // Returns the number of slots.
+  size_t capacity() const { return slots_.size(); }
+
+  // Returns the number of published slots not popped yet. Only a
+  // snapshot when called while the other thread is running.
+  size_t size() const {
+    return (head_.load(std::memory_order_acquire) & ~kEnded) -
+           (tail_.load(std::memory_order_acquire) & ~kEnded);
+  }
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  SpscRing(const SpscRing& other) = delete;
+  SpscRing& operator=(const SpscRing& other) = delete;
+
+ private:
+  // Constants
+  // The top bit of an index marks the end of the stream, which changes
+  // the value a waiting thread is waiting on and so wakes it up.
+  static constexpr size_t kEnded = size_t{1} << 63;
+  static constexpr size_t kCacheLine = 64;
+
+  std::vector<T> slots_;  // the slots, reused round and round
+  size_t mask_;           // slots_.size() - 1
+
+  // Each index is on its own cache line, next to the copy of the other
+  // index that its own thread keeps, so the two threads only touch each
+  // other's cache line when the copy is out of date.
+  alignas(kCacheLine) std::atomic<size_t> head_{0};  // slots published
+  size_t cached_tail_ = 0;  // producer's copy of tail_
+  alignas(kCacheLine) std::atomic<size_t> tail_{0};  // slots popped
+  size_t cached_head_ = 0;  // consumer's copy of head_
+};
+
+#endif  // SPSCRING_HPP_
@@ -0,0 +1,103 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <algorithm>
+#include <chrono>
+
+#include "TokenPipeline.hpp"
+using namespace std;
+
+// helper functions
+
+// Returns the nanoseconds since start
+static uint64_t ns_since(chrono::steady_clock::time_point start) {
+  return chrono::duration_cast<chrono::nanoseconds>(
+             chrono::steady_clock::now() - start)
+      .count();
+}
+
+TokenPipeline::TokenPipeline(const string& fname,
+                             const string& delims,
+                             size_t capacity,
+                             size_t max_lines,
+                             size_t max_bytes)
+    : reader_(fname, delims),
+      good_(reader_.good()),
+      max_lines_(max_lines),
+      max_bytes_(max_bytes),
+      ring_(capacity) {
+  producer_ = thread(&TokenPipeline::produce, this);
+}
+
+TokenPipeline::~TokenPipeline() {
+  ring_.cancel();
+  producer_.join();
+}
+
+void TokenPipeline::produce() {
+  while (true) {
+    LineBatch* batch = ring_.try_claim();
+    if (batch == nullptr) {
+      // the consumer is behind: wait for it to hand a batch back
+      producer_stalls_.fetch_add(1, memory_order_relaxed);
+      auto start = chrono::steady_clock::now();
+      batch = ring_.claim();
+      producer_wait_ns_.fetch_add(ns_since(start), memory_order_relaxed);
+      if (batch == nullptr) {
+        return;  // cancelled
+      }
+    }
+    size_t num_lines = batch->read(reader_, max_lines_, max_bytes_);
+    if (num_lines == 0) {
+      break;
+    }
+    ring_.publish();
+    batches_.fetch_add(1, memory_order_relaxed);
+    lines_.fetch_add(num_lines, memory_order_relaxed);
+    uint64_t depth = ring_.size();
+    if (depth > max_depth_.load(memory_order_relaxed)) {
+      max_depth_.store(depth, memory_order_relaxed);
+    }
+  }
+  ring_.close();
+}
+
+const LineBatch* TokenPipeline::next() {
+  if (holding_) {
+    ring_.pop();
+    holding_ = false;
+  }
+  LineBatch* batch = ring_.try_front();
+  if (batch == nullptr) {
+    // the producer is behind (or done): wait for it
+    consumer_stalls_.fetch_add(1, memory_order_relaxed);
+    auto start = chrono::steady_clock::now();
+    batch = ring_.front();
+    consumer_wait_ns_.fetch_add(ns_since(start), memory_order_relaxed);
+    if (batch == nullptr) {
+      return nullptr;
+    }
+  }
+  holding_ = true;
+  return batch;
+}
+
+TokenPipeline::Stats TokenPipeline::stats() const {
+  Stats stats;
+  stats.batches = batches_.load(memory_order_relaxed);
+  stats.lines = lines_.load(memory_order_relaxed);
+  stats.producer_stalls = producer_stalls_.load(memory_order_relaxed);
+  stats.consumer_stalls = consumer_stalls_.load(memory_order_relaxed);
+  stats.producer_wait_ns = producer_wait_ns_.load(memory_order_relaxed);
+  stats.consumer_wait_ns = consumer_wait_ns_.load(memory_order_relaxed);
+  stats.max_depth = max_depth_.load(memory_order_relaxed);
+  return stats;
+}
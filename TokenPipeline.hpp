@@ -0,0 +1,125 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef TOKENPIPELINE_HPP_
+#define TOKENPIPELINE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "BufferedFileReader.hpp"
+#include "LineBatch.hpp"
+#include "SpscRing.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// A TokenPipeline reads a file on its own thread, handing batches of
+// tokenized lines to the thread that uses them.
+//
+// The producer thread reads lines into LineBatches with a
+// BufferedFileReader and publishes them into a SpscRing, so reading and
+// tokenizing run at the same time as (and on another core from) whatever
+// is done with the lines, without any locks. At most capacity batches
+// are in flight, which bounds the memory used: when the consumer falls
+// behind, the producer waits. How often each side had to wait, and for
+// how long, is counted in Stats.
+///////////////////////////////////////////////////////////////////////////////
+class TokenPipeline {
+ public:
+  // Counters of the work done and the time each side spent waiting
+  // for the other.
+  struct Stats {
+    uint64_t batches = 0;          // batches published by the producer
+    uint64_t lines = 0;            // lines in those batches
+    uint64_t producer_stalls = 0;  // times the ring was full
+    uint64_t consumer_stalls = 0;  // times the ring was empty
+    uint64_t producer_wait_ns = 0;  // time the producer waited for room
+    uint64_t consumer_wait_ns = 0;  // time the consumer waited for lines
+    uint64_t max_depth = 0;  // most batches ever waiting in the ring
+  };
+
+  // Constructor for a TokenPipeline. Opens the file and starts the
+  // producer thread.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  // - capacity: the most batches in flight at once, rounded up to a
+  //   power of two
+  // - max_lines, max_bytes: the size of each batch, as for
+  //   LineBatch::read()
+  TokenPipeline(const std::string& fname,
+                const std::string& delims = "\r\n\t ",
+                size_t capacity = 8,
+                size_t max_lines = 1024,
+                size_t max_bytes = 1 << 20);
+
+  // Destructor for a TokenPipeline. Stops the producer thread, even if
+  // the file has not been read to the end, and closes the file.
+  //
+  // Arguments: None
+  ~TokenPipeline();
+
+  // Gets the next batch of lines, waiting for the producer if it has
+  // not read it yet. The batch returned by the previous call is handed
+  // back to the producer to be reused, so it must not be used anymore.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - the next batch, which is valid until the next call to next()
+  // - nullptr once every line of the file has been returned
+  const LineBatch* next();
+
+  // Returns whether the file was opened.
+  //
+  // Arguments: None
+  bool good() const { return good_; }
+
+  // Returns a snapshot of the counters. Can be called while the
+  // pipeline is running.
+  //
+  // Arguments: None
+  Stats stats() const;
+
+  // Ignore These
+  // If you want to know more, this is disabling the
+  // copy constructor and the assignment operator.
+  TokenPipeline(const TokenPipeline& other) = delete;
+  TokenPipeline& operator=(const TokenPipeline& other) = delete;
+
+ private:
+  // The body of the producer thread
+  void produce();
+
+  // fields
+  BufferedFileReader reader_;  // only used by the producer thread
+  bool good_;                  // whether the file was opened
+  size_t max_lines_;           // lines per batch
+  size_t max_bytes_;           // bytes per batch
+  SpscRing<LineBatch> ring_;   // batches between the two threads
+  bool holding_ = false;       // whether the consumer has a batch out
+
+  // counters, each only written by one of the two threads
+  std::atomic<uint64_t> batches_{0};
+  std::atomic<uint64_t> lines_{0};
+  std::atomic<uint64_t> producer_stalls_{0};
+  std::atomic<uint64_t> consumer_stalls_{0};
+  std::atomic<uint64_t> producer_wait_ns_{0};
+  std::atomic<uint64_t> consumer_wait_ns_{0};
+  std::atomic<uint64_t> max_depth_{0};
+
+  std::thread producer_;  // the producer thread, started last
+};
+
+#endif  // TOKENPIPELINE_HPP_
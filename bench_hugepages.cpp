@@ -0,0 +1,129 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+// Compares reading a large file with O_DIRECT into 8 MiB buffers backed
+// by 4 KiB pages and by huge pages. Built with optimizations by
+// "make bench", outside of the -O0 test_suite, so that the time is
+// spent in the reader rather than in unoptimized code.
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string>
+
+#include "BufferedFileReader.hpp"
+
+using namespace std;
+
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+// helper functions
+
+// Returns the value of the given field of a /proc file such as
+// /proc/meminfo, in the units the file uses, or -1 if it has none
+static int64_t proc_field(const string& path, const string& field) {
+  ifstream ifs(path);
+  string name;
+  int64_t value;
+  while (ifs >> name) {
+    if (name == field + ":" && ifs >> value) {
+      return value;
+    }
+    ifs.ignore(numeric_limits<streamsize>::max(), '\n');
+  }
+  return -1;
+}
+
+// Returns the ns per byte it takes to read every token of the file
+static double ns_per_byte_for_tokens(BufferedFileReader& bf,
+                                     size_t length,
+                                     uint64_t* num_tokens) {
+  auto start = chrono::steady_clock::now();
+  *num_tokens = 0;
+  while (bf.get_token().has_value()) {
+    (*num_tokens)++;
+  }
+  auto ns = chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now() - start)
+                .count();
+  return static_cast<double>(ns) / length;
+}
+
+int main() {
+  // "War and Peace" 8 times over, about 25 MB, so the I/O is the same
+  // with or without huge pages
+  ifstream ifs(kLongFileName);
+  string contents((istreambuf_iterator<char>(ifs)),
+                  istreambuf_iterator<char>());
+  if (contents.empty()) {
+    cerr << "can't read " << kLongFileName << endl;
+    return EXIT_FAILURE;
+  }
+  char fname[] = "/tmp/bench_hugepagesXXXXXX";
+  int fd = mkstemp(fname);
+  if (fd < 0) {
+    cerr << "can't create " << fname << endl;
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < 8; i++) {
+    if (write(fd, contents.data(), contents.length()) !=
+        static_cast<ssize_t>(contents.length())) {
+      cerr << "can't write " << fname << endl;
+      close(fd);
+      unlink(fname);
+      return EXIT_FAILURE;
+    }
+  }
+  close(fd);
+  size_t length = contents.length() * 8;
+
+  // allocate_huge() uses MAP_HUGETLB only if huge pages are reserved
+  int64_t reserved = proc_field("/proc/meminfo", "HugePages_Total");
+  cout << "huge page path: "
+       << (reserved > 0 ? "MAP_HUGETLB" : "transparent huge pages")
+       << " (HugePages_Total " << reserved << ")" << endl;
+
+  uint64_t small_tokens = 0;
+  uint64_t huge_tokens = 0;
+  double small_ns = 0;
+  double huge_ns = 0;
+  {
+    BufferedFileReader small_pages(fname, "\r\n\t ",
+                                   BufferedFileReader::Direct{8 << 20, false});
+    small_ns = ns_per_byte_for_tokens(small_pages, length, &small_tokens);
+  }
+  {
+    BufferedFileReader huge_pages(fname, "\r\n\t ",
+                                  BufferedFileReader::Direct{8 << 20, true});
+    huge_ns = ns_per_byte_for_tokens(huge_pages, length, &huge_tokens);
+    // whether the kernel actually gave the buffer transparent huge pages
+    cout << "AnonHugePages while reading: "
+         << proc_field("/proc/self/smaps_rollup", "AnonHugePages") << " kB"
+         << endl;
+  }
+  unlink(fname);
+
+  cout << "ns/byte for get_token over " << length
+       << " bytes with 8 MiB buffers: " << small_ns << " (4 KiB pages), "
+       << huge_ns << " (huge pages)" << endl;
+  if (small_tokens != huge_tokens) {
+    cerr << "token counts differ: " << small_tokens << " vs " << huge_tokens
+         << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
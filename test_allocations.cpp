@@ -0,0 +1,244 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <bit>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./ReaderPool.hpp"
+#include "./SimpleFileReader.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+// Allocation counters. operator new is replaced for the whole
+// test binary, but only allocations made while counting is turned on
+// (between the constructor and stop() of an AllocationCounter) are recorded.
+// That keeps catch's own bookkeeping inside REQUIRE out of the numbers.
+// They are thread_local, so only the thread that made the counter is
+// counted, and helper threads (decoders, pipelines, dispatchers) that
+// allocate at the same time don't race on them.
+static thread_local bool counting = false;
+static thread_local uint64_t num_allocs = 0;
+static thread_local uint64_t num_bytes = 0;
+
+void* operator new(size_t size) {
+  if (counting) {
+    num_allocs++;
+    num_bytes += size;
+  }
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t /* size */) noexcept {
+  free(ptr);
+}
+
+// Counts the heap allocations made between construction and stop().
+class AllocationCounter {
+ public:
+  AllocationCounter() : allocs_(num_allocs), bytes_(num_bytes) {
+    counting = true;
+  }
+
+  ~AllocationCounter() { counting = false; }
+
+  void stop() {
+    counting = false;
+    allocs_ = num_allocs - allocs_;
+    bytes_ = num_bytes - bytes_;
+  }
+
+  uint64_t allocs() const { return allocs_; }
+  uint64_t bytes() const { return bytes_; }
+
+ private:
+  uint64_t allocs_;
+  uint64_t bytes_;
+};
+
+// helper functions
+
+// A token that fits in the small string buffer never touches the heap.
+static bool is_short(const string& token) {
+  return token.length() < string().capacity();
+}
+
+TEST_CASE("get_char", "[Test_Allocations]") {
+  BufferedFileReader bf(kLongFileName);
+  SimpleFileReader sf(kLongFileName);
+
+  AllocationCounter counter;
+  while (bf.get_char() != EOF) {
+  }
+  for (int i = 0; i < 1000; i++) {
+    sf.get_char();
+  }
+  counter.stop();
+
+  REQUIRE(counter.allocs() == 0);
+}
+
+TEST_CASE("get_token", "[Test_Allocations]") {
+  BufferedFileReader bf(kLongFileName);
+  optional<string> opt{};
+  uint64_t short_tokens = 0;
+
+  while (bf.good()) {
+    AllocationCounter counter;
+    opt = bf.get_token();
+    counter.stop();
+    if (!opt.has_value()) {
+      break;
+    }
+    // The token is built in place and returned by move, so a short
+    // token costs nothing and a long token at most one allocation
+    // (two if it straddles a buffer refill).
+    if (is_short(opt.value())) {
+      REQUIRE(counter.allocs() == 0);
+      short_tokens++;
+    } else {
+      REQUIRE(counter.allocs() <= 2);
+    }
+  }
+  REQUIRE(short_tokens > 0);
+}
+
+TEST_CASE("get_line", "[Test_Allocations]") {
+  BufferedFileReader bf(kLongFileName);
+  optional<vector<string>> opt{};
+
+  while (bf.good()) {
+    AllocationCounter counter;
+    opt = bf.get_line();
+    counter.stop();
+    if (!opt.has_value()) {
+      break;
+    }
+    // one allocation per growth of the vector, plus one per long token
+    // (two if it straddles a buffer refill)
+    uint64_t budget = bit_width(opt.value().size()) + 1;
+    for (const string& token : opt.value()) {
+      if (!is_short(token)) {
+        budget += 2;
+      }
+    }
+    REQUIRE(counter.allocs() <= budget);
+  }
+}
+
+TEST_CASE("pmr", "[Test_Allocations]") {
+  BufferedFileReader bf(kLongFileName);
+  vector<char> arena(1 << 20);
+  // null_memory_resource upstream: running out of arena throws
+  // instead of quietly falling back to the heap
+  pmr::monotonic_buffer_resource resource(arena.data(), arena.size(),
+                                          pmr::null_memory_resource());
+  uint64_t lines = 0;
+
+  AllocationCounter counter;
+  while (bf.good()) {
+    // release everything every 100 lines, like a batch would
+    if (lines % 100 == 0) {
+      resource.release();
+    }
+    if (lines % 2 == 0) {
+      bf.get_line(&resource);
+    } else {
+      bf.get_token(&resource);
+    }
+    lines++;
+  }
+  counter.stop();
+
+  REQUIRE(counter.allocs() == 0);
+}
+
+TEST_CASE("position", "[Test_Allocations]") {
+  BufferedFileReader bf(kHelloFileName);
+  SimpleFileReader sf(kHelloFileName);
+
+  AllocationCounter counter;
+  for (int i = 0; i < 100; i++) {
+    bf.tell();
+    bf.good();
+    sf.tell();
+    sf.good();
+  }
+  bf.rewind();
+  sf.rewind();
+  counter.stop();
+
+  REQUIRE(counter.allocs() == 0);
+}
+
+TEST_CASE("ReaderPool", "[Test_Allocations]") {
+  ReaderPool pool;
+  pool.release(pool.acquire(kLongFileName));
+
+  // once the pool has a reader, opening file after file allocates nothing
+  string hello(kHelloFileName);
+  string long_name(kLongFileName);
+  AllocationCounter counter;
+  for (int i = 0; i < 100; i++) {
+    BufferedFileReader reader = pool.acquire(i % 2 == 0 ? hello : long_name);
+    reader.get_char();
+    pool.release(std::move(reader));
+  }
+  counter.stop();
+
+  REQUIRE(counter.allocs() == 0);
+  REQUIRE(pool.num_created() == 1);
+}
+
+TEST_CASE("Benchmark", "[Test_Allocations]") {
+  BufferedFileReader bf(kLongFileName);
+  uint64_t token_calls = 0;
+  uint64_t line_calls = 0;
+
+  AllocationCounter token_counter;
+  while (bf.get_token().has_value()) {
+    token_calls++;
+  }
+  token_counter.stop();
+  std::cout << "get_token: " << token_calls << " calls, "
+            << token_counter.allocs() << " allocations, "
+            << token_counter.bytes() << " bytes" << std::endl;
+
+  bf.rewind();
+  AllocationCounter line_counter;
+  while (bf.get_line().has_value()) {
+    line_calls++;
+  }
+  line_counter.stop();
+  std::cout << "get_line: " << line_calls << " calls, "
+            << line_counter.allocs() << " allocations, "
+            << line_counter.bytes() << " bytes" << std::endl;
+
+  REQUIRE(token_counter.allocs() < token_calls);
+}
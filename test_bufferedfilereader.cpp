@@ -10,18 +10,30 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/mman.h>
 #include <sys/select.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <thread>
 #include "./BufferChecker.hpp"
 #include "./BufferedFileReader.hpp"
+#include "./OpenFileLimit.hpp"
 #include "catch.hpp"
 
 using namespace std;
 static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
 static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+// bigger than the buffer, but small enough to be read whole
+static constexpr const char* kMediumFileName = "./test_files/Medium.txt";
 static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
 static constexpr const char* kGreatFileName = "./test_files/mutual_aid.txt";
 
@@ -58,6 +70,24 @@ static bool verify_token(const string& actual,
   return true;
 }
 
+// Returns how many pages of the file are in the page cache
+static size_t resident_pages(const char* fname) {
+  int fd = open(fname, O_RDONLY);
+  struct stat st {};
+  fstat(fd, &st);
+  void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  vector<unsigned char> pages((st.st_size + page_size - 1) / page_size);
+  mincore(mapping, st.st_size, pages.data());
+  munmap(mapping, st.st_size);
+  close(fd);
+  size_t resident = 0;
+  for (unsigned char page : pages) {
+    resident += page & 1;
+  }
+  return resident;
+}
+
 // Ensures that the last token has a new line character after it
 static bool verify_tokens(const vector<string> actual,
                           const string& expected_contents,
@@ -195,6 +225,24 @@ TEST_CASE("get_char", "[Test_BufferedFileReader]") {
   REQUIRE(EOF == c);
   REQUIRE_FALSE(bf.good());
 
+  // Medium file test case
+  ifstream medium_ifs(kMediumFileName);
+  string kMediumContents((std::istreambuf_iterator<char>(medium_ifs)),
+                         (std::istreambuf_iterator<char>()));
+  REQUIRE(kMediumContents.length() > 1024);  // BUF_SIZE
+  bf.open_file(kMediumFileName);
+  contents.clear();
+  for (size_t i = 0; i < kMediumContents.length(); i++) {
+    REQUIRE(i == static_cast<size_t>(bf.tell()));
+    c = bf.get_char();
+    contents += c;
+    REQUIRE(bf.good());
+    REQUIRE_FALSE(bc.check_char_errors(c, i));
+  }
+  REQUIRE(kMediumContents == contents);
+  REQUIRE(EOF == bf.get_char());
+  REQUIRE_FALSE(bf.good());
+
   // Long file test case
   contents.clear();
   bf.close_file();
@@ -264,6 +312,21 @@ TEST_CASE("get_token", "[Test_BufferedFileReader]") {
 
   REQUIRE(static_cast<off_t>(kHelloContents.length()) == offset);
 
+  ifstream medium_ifs(kMediumFileName);
+  string kMediumContents((std::istreambuf_iterator<char>(medium_ifs)),
+                         (std::istreambuf_iterator<char>()));
+  offset = 0;
+  bf.open_file(kMediumFileName);
+  while (bf.good()) {
+    opt = bf.get_token();
+    REQUIRE(opt.has_value());
+    token = opt.value();
+    REQUIRE_FALSE(bc.check_token_errors(token, offset));
+    REQUIRE(verify_token(token, kMediumContents, delims, &offset));
+    REQUIRE(offset == static_cast<off_t>(bf.tell()));
+  }
+  REQUIRE(static_cast<off_t>(kMediumContents.length()) == offset);
+
   offset = 0;
   bf.open_file(kLongFileName);
   while (bf.good()) {
@@ -385,4 +448,861 @@ TEST_CASE("Complex", "[Test_BufferedFileReader]") {
     offset = 0;
     bf.rewind();
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("pmr", "[Test_BufferedFileReader]") {
+  // declared first so it outlives everything allocated from it
+  pmr::monotonic_buffer_resource resource;
+  optional<vector<string>> opt{};
+  optional<pmr::vector<pmr::string>> pmr_opt{};
+  optional<string> token{};
+  optional<pmr::string> pmr_token{};
+  string delims = ",\t ";
+
+  BufferedFileReader bf(kGreatFileName, delims);
+  BufferedFileReader pmr_bf(kGreatFileName, delims);
+
+  while (bf.good()) {
+    opt = bf.get_line();
+    pmr_opt = pmr_bf.get_line(&resource);
+    REQUIRE(opt.has_value());
+    REQUIRE(pmr_opt.has_value());
+    REQUIRE(opt.value().size() == pmr_opt.value().size());
+    for (size_t i = 0; i < opt.value().size(); i++) {
+      REQUIRE(string_view(opt.value().at(i)) == pmr_opt.value().at(i));
+      REQUIRE(pmr_opt.value().at(i).get_allocator().resource() == &resource);
+    }
+    REQUIRE(bf.tell() == pmr_bf.tell());
+
+    token = bf.get_token();
+    pmr_token = pmr_bf.get_token(&resource);
+    REQUIRE(token.has_value() == pmr_token.has_value());
+    if (token.has_value()) {
+      REQUIRE(string_view(token.value()) == pmr_token.value());
+    }
+    REQUIRE(bf.good() == pmr_bf.good());
+  }
+  REQUIRE_FALSE(pmr_bf.get_line(&resource).has_value());
+  REQUIRE_FALSE(pmr_bf.get_token(&resource).has_value());
+}
+
+TEST_CASE("Delims", "[Test_BufferedFileReader]") {
+  static_assert(DefaultDelims::kTable == make_delim_table("\r\n\t "));
+  static_assert(Delims<>::kTable == DelimTable{});
+
+  optional<string> opt{};
+  optional<vector<string>> tok_opt{};
+  string delims = ",\t ";
+
+  BufferedFileReader bf(kLongFileName, delims);
+  BufferedFileReader fixed_bf(kLongFileName, Delims<',', '\t', ' '>{});
+  BufferChecker bc(fixed_bf);
+  off_t offset = 0;
+
+  while (bf.good()) {
+    opt = fixed_bf.get_token();
+    REQUIRE(opt == bf.get_token());
+    if (opt.has_value()) {
+      REQUIRE_FALSE(bc.check_token_errors(opt.value(), offset));
+    }
+    tok_opt = fixed_bf.get_line();
+    REQUIRE(tok_opt == bf.get_line());
+    offset = fixed_bf.tell();
+    REQUIRE(offset == bf.tell());
+  }
+  REQUIRE_FALSE(fixed_bf.good());
+
+  // default delimiters
+  BufferedFileReader default_bf(kHelloFileName);
+  BufferedFileReader default_fixed_bf(kHelloFileName, DefaultDelims{});
+  while (default_bf.good()) {
+    REQUIRE(default_fixed_bf.get_token() == default_bf.get_token());
+  }
+  REQUIRE_FALSE(default_fixed_bf.good());
+}
+
+// Splits contents into tokens the way a reader with the given
+// multi-char delimiters should. If line_mode, '\n' also ends a token
+// and the tokens are grouped into lines.
+static vector<vector<string>> split_multi(const string& contents,
+                                         const vector<string>& delims,
+                                         bool line_mode) {
+  vector<vector<string>> lines(1);
+  string token;
+  size_t i = 0;
+  while (i < contents.length()) {
+    size_t matched = 0;
+    for (const string& delim : delims) {
+      if (contents.compare(i, delim.length(), delim) == 0) {
+        matched = delim.length();
+      }
+    }
+    bool newline = line_mode && matched == 0 && contents[i] == '\n';
+    if (matched == 0 && !newline) {
+      token += contents[i++];
+      continue;
+    }
+    i += matched > 0 ? matched : 1;
+    lines.back().push_back(token);
+    token.clear();
+    if (line_mode && contents[i - 1] == '\n') {
+      lines.emplace_back();
+    }
+  }
+  if (!line_mode && !token.empty()) {
+    lines.back().push_back(token);
+  }
+  return lines;
+}
+
+TEST_CASE("multi_char_delims", "[Test_BufferedFileReader]") {
+  vector<string> delims{"\r\n", "||", "<SEP>"};
+
+  // partial delimiters like "<SE" and "|" stay in the token, and token
+  // lengths vary so delimiters land on every offset of a buffer boundary
+  string contents;
+  for (int i = 0; i < 3000; i++) {
+    contents += string(i % 37, static_cast<char>('a' + i % 26));
+    if (i % 11 == 0) {
+      contents += "<SE";
+    }
+    if (i % 13 == 0) {
+      contents += "|x";
+    }
+    contents += delims.at(i % delims.size());
+    if (i % 17 == 0) {
+      contents += "\n";
+    }
+  }
+  contents += "last";
+
+  char fname[] = "/tmp/multi_delimsXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  REQUIRE(write(fd, contents.data(), contents.length()) ==
+          static_cast<ssize_t>(contents.length()));
+  close(fd);
+
+  // get_token
+  vector<string> expected = split_multi(contents, delims, false).at(0);
+  BufferedFileReader bf(fname, delims);
+  for (const string& token : expected) {
+    optional<string> opt = bf.get_token();
+    REQUIRE(opt.has_value());
+    REQUIRE(opt.value() == token);
+  }
+  REQUIRE_FALSE(bf.get_token().has_value());
+  REQUIRE_FALSE(bf.good());
+
+  // get_line, with the reader reopened to check the delimiters survive
+  vector<vector<string>> expected_lines = split_multi(contents, delims, true);
+  bf.close_file();
+  bf.open_file(fname);
+  for (size_t i = 0; i + 1 < expected_lines.size(); i++) {
+    optional<vector<string>> opt = bf.get_line();
+    REQUIRE(opt.has_value());
+    REQUIRE(opt.value() == expected_lines.at(i));
+  }
+  REQUIRE(static_cast<size_t>(bf.tell()) <= contents.length());
+
+  unlink(fname);
+}
+
+TEST_CASE("DelimiterMatcher", "[Test_BufferedFileReader]") {
+  DelimiterMatcher matcher({"he", "she", "his", "hers", ""});
+  string text = "ushers";
+  vector<int32_t> lengths;
+  int32_t state = DelimiterMatcher::kStart;
+  for (char c : text) {
+    state = matcher.next(state, c);
+    lengths.push_back(matcher.match_length(state));
+  }
+  // "she" and "he" both end at the 'e', the longer one is reported
+  REQUIRE(lengths == vector<int32_t>{0, 0, 0, 3, 0, 4});
+}
+
+TEST_CASE("follow", "[Test_BufferedFileReader]") {
+  char fname[] = "/tmp/followXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  string start = "abc def gh";
+  REQUIRE(write(fd, start.data(), start.length()) ==
+          static_cast<ssize_t>(start.length()));
+
+  BufferedFileReader bf(fname, " ");
+  bf.set_follow(true, 50);
+  REQUIRE(bf.get_token() == "abc");
+  REQUIRE(bf.get_token() == "def");
+
+  // "gh" may not be finished, so it is held back
+  REQUIRE_FALSE(bf.get_token().has_value());
+  REQUIRE(bf.good());
+  REQUIRE(bf.tell() == 8);
+  REQUIRE_FALSE(bf.get_line().has_value());
+  REQUIRE(bf.good());
+  REQUIRE(bf.tell() == 8);
+
+  // the rest of the token shows up while we wait
+  bf.set_follow(true, -1);
+  // (catch assertions are not thread safe, so the writers only
+  // record whether their writes worked)
+  bool wrote = false;
+  thread writer([fd, &wrote]() {
+    this_thread::sleep_for(chrono::milliseconds(20));
+    wrote = write(fd, "i", 1) == 1;
+    this_thread::sleep_for(chrono::milliseconds(20));
+    wrote = wrote && write(fd, "j k\n", 4) == 4;
+  });
+  REQUIRE(bf.get_token() == "ghij");
+  REQUIRE(bf.get_line() == vector<string>{"k"});
+  writer.join();
+  REQUIRE(wrote);
+
+  // lines longer than the buffer, written in pieces
+  string line;
+  for (int i = 0; i < 500; i++) {
+    line += to_string(i) + " ";
+  }
+  thread long_writer([fd, &line, &wrote]() {
+    for (size_t i = 0; i < line.length(); i += 700) {
+      string piece = line.substr(i, 700);
+      wrote = wrote && write(fd, piece.data(), piece.length()) ==
+                           static_cast<ssize_t>(piece.length());
+      this_thread::sleep_for(chrono::milliseconds(5));
+    }
+    wrote = wrote && write(fd, "\n", 1) == 1;
+  });
+  optional<vector<string>> opt = bf.get_line();
+  long_writer.join();
+  REQUIRE(wrote);
+  REQUIRE(opt.has_value());
+  REQUIRE(opt.value().size() == 501);
+  REQUIRE(opt.value().at(499) == "499");
+
+  bf.set_follow(false);
+  REQUIRE_FALSE(bf.get_token().has_value());
+  REQUIRE_FALSE(bf.good());
+
+  close(fd);
+  unlink(fname);
+}
+
+TEST_CASE("non_seekable", "[Test_BufferedFileReader]") {
+  // file descriptor of a regular file, opened part way through
+  int file_fd = open(kHelloFileName, O_RDONLY);
+  REQUIRE(file_fd >= 0);
+  REQUIRE(lseek(file_fd, 2, SEEK_SET) == 2);
+  BufferedFileReader from_fd(file_fd);
+  REQUIRE(from_fd.seekable());
+  REQUIRE(from_fd.tell() == 2);
+  REQUIRE('l' == from_fd.get_char());
+  REQUIRE(from_fd.rewind());
+  REQUIRE('H' == from_fd.get_char());
+
+  // a pipe, written by another thread in pieces longer than the buffer
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  string contents;
+  for (int i = 0; i < 2000; i++) {
+    contents += to_string(i) + (i % 10 == 9 ? "\n" : " ");
+  }
+  bool wrote = true;
+  thread writer([fd = fds[1], &contents, &wrote]() {
+    for (size_t i = 0; i < contents.length(); i += 3000) {
+      string piece = contents.substr(i, 3000);
+      wrote = wrote && write(fd, piece.data(), piece.length()) ==
+                           static_cast<ssize_t>(piece.length());
+    }
+    close(fd);
+  });
+
+  BufferedFileReader bf(fds[0]);
+  REQUIRE(bf.good());
+  REQUIRE_FALSE(bf.seekable());
+  REQUIRE(bf.tell() == 0);
+  REQUIRE(bf.get_token() == "0");
+  REQUIRE(bf.tell() == 2);
+
+  // seeking within the buffer still works, but not back to the start
+  // once the buffer has moved on
+  REQUIRE(bf.seek(0));
+  REQUIRE(bf.get_token() == "0");
+  for (int i = 1; i < 2000; i++) {
+    REQUIRE(bf.get_token() == to_string(i));
+  }
+  REQUIRE_FALSE(bf.get_token().has_value());
+  REQUIRE_FALSE(bf.good());
+  REQUIRE(static_cast<size_t>(bf.tell()) == contents.length());
+  REQUIRE_FALSE(bf.rewind());
+  REQUIRE_FALSE(bf.seek(0));
+  writer.join();
+  REQUIRE(wrote);
+
+  // following a pipe makes no sense, it is ignored
+  REQUIRE(pipe(fds) == 0);
+  close(fds[1]);
+  BufferedFileReader closed(fds[0]);
+  closed.set_follow(true, 10);
+  REQUIRE_FALSE(closed.get_token().has_value());
+  REQUIRE_FALSE(closed.good());
+}
+
+TEST_CASE("large_file", "[Test_BufferedFileReader]") {
+  // a sparse file just over 5 GiB, with a few tokens past 4 GiB
+  constexpr off_t kGiB = off_t{1} << 30;
+  constexpr off_t kSize = 5 * kGiB + 123;
+  constexpr off_t kMarker = 4 * kGiB + 1000;
+  char fname[] = "/tmp/large_fileXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  REQUIRE(ftruncate(fd, kSize) == 0);
+  string marker = "\nfirst second\nthird\n";
+  REQUIRE(pwrite(fd, marker.data(), marker.length(), kMarker) ==
+          static_cast<ssize_t>(marker.length()));
+  string end = " last";
+  REQUIRE(pwrite(fd, end.data(), end.length(), kSize - end.length()) ==
+          static_cast<ssize_t>(end.length()));
+  close(fd);
+
+  BufferedFileReader bf(fname, " \n");
+  REQUIRE(bf.seek(kMarker + 1));
+  REQUIRE(bf.tell() == kMarker + 1);
+  REQUIRE(bf.get_token() == "first");
+  REQUIRE(bf.tell() == kMarker + 7);
+  REQUIRE(bf.get_line() == vector<string>{"second"});
+  REQUIRE(bf.get_line() == vector<string>{"third"});
+  REQUIRE(bf.tell() == kMarker + static_cast<off_t>(marker.length()));
+
+  // reading up to the end of the file
+  REQUIRE(bf.seek(kSize - 3000));
+  REQUIRE(bf.get_token() == string(3000 - end.length(), '\0'));
+  REQUIRE(bf.get_token() == "last");
+  REQUIRE_FALSE(bf.get_token().has_value());
+  REQUIRE(bf.tell() == kSize);
+
+  // seeking back below 4 GiB and within the buffer
+  REQUIRE(bf.seek(kMarker + 7));
+  REQUIRE(bf.get_token() == "second");
+  REQUIRE(bf.seek(kSize - end.length() + 1));
+  REQUIRE(bf.get_char() == 'l');
+  REQUIRE(bf.tell() == kSize - static_cast<off_t>(end.length()) + 2);
+  unlink(fname);
+}
+
+TEST_CASE("seek", "[Test_BufferedFileReader]") {
+  ifstream file(kLongFileName);
+  string contents((istreambuf_iterator<char>(file)),
+                  istreambuf_iterator<char>());
+  BufferedFileReader bf(kLongFileName, " \n");
+  REQUIRE(bf.seek(200000));
+  REQUIRE(bf.tell() == 200000);
+  REQUIRE(bf.get_char() == contents.at(200000));
+
+  // a negative offset is refused, and the reader doesn't move
+  REQUIRE_FALSE(bf.seek(-1));
+  REQUIRE_FALSE(bf.seek(-5000));
+  REQUIRE(bf.tell() == 200001);
+  REQUIRE(bf.get_char() == contents.at(200001));
+
+  // past the end of the file leaves the reader at the end
+  REQUIRE(bf.seek(10000000));
+  REQUIRE(static_cast<size_t>(bf.tell()) == contents.length());
+  REQUIRE_FALSE(bf.get_token().has_value());
+  REQUIRE(bf.get_char() == EOF);
+  REQUIRE(bf.seek(contents.length() + 1));
+  REQUIRE(static_cast<size_t>(bf.tell()) == contents.length());
+  REQUIRE(bf.seek(contents.length() - 1));
+  REQUIRE(bf.get_char() == contents.back());
+  REQUIRE(bf.get_char() == EOF);
+
+  // and so does a reader whose file is parked
+  BufferedFileReader lazy(kLongFileName, " \n", BufferedFileReader::Lazy{});
+  REQUIRE_FALSE(lazy.seek(-1));
+  REQUIRE(lazy.seek(10000000));
+  REQUIRE(static_cast<size_t>(lazy.tell()) == contents.length());
+  REQUIRE(lazy.seek(0));
+  REQUIRE(lazy.get_char() == contents.at(0));
+}
+
+TEST_CASE("small_file", "[Test_BufferedFileReader]") {
+  // a file bigger than the buffer, but small enough to be read whole
+  char fname[] = "/tmp/small_fileXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  string contents;
+  for (int i = 0; contents.length() < 40000; i++) {
+    contents += to_string(i) + (i % 10 == 9 ? "\n" : " ");
+  }
+  REQUIRE(write(fd, contents.data(), contents.length()) ==
+          static_cast<ssize_t>(contents.length()));
+
+  // the reader's descriptor is closed as soon as the file is read,
+  // so the next descriptor opened gets the same number as before
+  int before = dup(STDIN_FILENO);
+  close(before);
+  BufferedFileReader bf(fname);
+  int after = dup(STDIN_FILENO);
+  close(after);
+  REQUIRE(before == after);
+
+  REQUIRE(bf.good());
+  REQUIRE(bf.seekable());
+  REQUIRE(bf.get_line() ==
+          vector<string>{"0", "1", "2", "3", "4", "5", "6", "7", "8", "9"});
+  int i = 10;
+  for (optional<string> token = bf.get_token(); token.has_value();
+       token = bf.get_token()) {
+    REQUIRE(token == to_string(i++));
+  }
+  REQUIRE_FALSE(bf.good());
+  REQUIRE(static_cast<size_t>(bf.tell()) == contents.length());
+
+  // seeking and rewinding don't need the file again
+  REQUIRE(bf.seek(contents.find("1234 ")));
+  REQUIRE(bf.get_token() == "1234");
+  REQUIRE(bf.seek(contents.length() + 10));
+  REQUIRE_FALSE(bf.get_token().has_value());
+  REQUIRE(bf.rewind());
+  REQUIRE(bf.get_token() == "0");
+
+  // following the file opens it again, carrying on after what was read
+  REQUIRE(bf.seek(contents.length()));
+  bf.set_follow(true, 50);
+  REQUIRE(write(fd, "more\n", 5) == 5);
+  REQUIRE(bf.get_line() == vector<string>{"more"});
+  REQUIRE_FALSE(bf.get_line().has_value());
+  REQUIRE(bf.good());
+  bf.close_file();
+  REQUIRE(bf.tell() == -1);
+  close(fd);
+  unlink(fname);
+}
+
+TEST_CASE("lazy", "[Test_BufferedFileReader]") {
+  // the tokens every reader should read
+  BufferedFileReader expected_bf(kLongFileName);
+  vector<string> expected;
+  for (int i = 0; i < 3000; i++) {
+    expected.push_back(expected_bf.get_token().value());
+  }
+
+  // nothing is opened until the readers are read from
+  constexpr size_t kNumReaders = 10;
+  OpenFileLimit limit(3);
+  int before = dup(STDIN_FILENO);
+  close(before);
+  vector<BufferedFileReader> readers;
+  for (size_t i = 0; i < kNumReaders; i++) {
+    readers.emplace_back(kLongFileName, "\r\n\t ",
+                         BufferedFileReader::Lazy{&limit});
+  }
+  int after = dup(STDIN_FILENO);
+  close(after);
+  REQUIRE(before == after);
+  REQUIRE(limit.num_open() == 0);
+  REQUIRE(readers.at(0).good());
+  REQUIRE(readers.at(0).tell() == 0);
+
+  // taking turns, so files keep being closed and opened again
+  // where they were
+  for (const string& token : expected) {
+    for (BufferedFileReader& reader : readers) {
+      REQUIRE(reader.get_token() == token);
+      REQUIRE(limit.num_open() <= 3);
+    }
+  }
+  REQUIRE(limit.num_open() == 3);
+  REQUIRE(limit.num_evicted() > 0);
+
+  // seeking and rewinding a reader whose file was closed
+  ifstream long_ifs(kLongFileName);
+  string contents((std::istreambuf_iterator<char>(long_ifs)),
+                  (std::istreambuf_iterator<char>()));
+  // doesn't open it again (the last three readers read still have
+  // theirs open), until it is read from
+  uint64_t evicted = limit.num_evicted();
+  int fds_before = dup(STDIN_FILENO);
+  close(fds_before);
+  for (size_t i = 0; i < kNumReaders - 3; i++) {
+    REQUIRE(readers.at(i).seek(100000 * i + 7));
+    REQUIRE(readers.at(i).tell() == static_cast<off_t>(100000 * i + 7));
+    REQUIRE(readers.at(i).rewind());
+    REQUIRE(readers.at(i).seek(100000 * i + 5));
+  }
+  int fds_after = dup(STDIN_FILENO);
+  close(fds_after);
+  REQUIRE(fds_before == fds_after);
+  REQUIRE(limit.num_open() == 3);
+  REQUIRE(limit.num_evicted() == evicted);
+  REQUIRE(readers.at(1).get_char() == contents.at(100005));
+  REQUIRE(limit.num_evicted() == evicted + 1);
+
+  // a lazy reader that hasn't read yet only opens its file to seek
+  // past the start
+  BufferedFileReader unread(kLongFileName, " ",
+                            BufferedFileReader::Lazy{&limit});
+  REQUIRE(unread.seek(0));
+  REQUIRE(unread.rewind());
+  REQUIRE(limit.num_evicted() == evicted + 1);
+  REQUIRE(unread.seek(12345));
+  REQUIRE(limit.num_evicted() == evicted + 2);
+  REQUIRE(unread.get_char() == contents.at(12345));
+  unread.close_file();
+
+  BufferedFileReader& first = readers.at(0);
+  off_t pos = first.tell();
+  for (size_t i = 1; i < kNumReaders; i++) {
+    REQUIRE(readers.at(i).seek(100000 * i));
+    REQUIRE(readers.at(i).get_char() == contents.at(100000 * i));
+  }
+  REQUIRE(first.seek(pos + 50000));
+  REQUIRE(first.get_char() == contents.at(pos + 50000));
+  REQUIRE(first.rewind());
+  REQUIRE(first.get_token() == expected.at(0));
+
+  // moving a reader keeps its place in the group
+  BufferedFileReader moved = std::move(readers.at(1));
+  REQUIRE(moved.tell() == 100001);
+  REQUIRE(moved.get_char() == contents.at(100001));
+  readers.clear();
+  REQUIRE(moved.seek(2000000));
+  REQUIRE(moved.get_char() == contents.at(2000000));
+  REQUIRE(limit.num_open() == 1);
+  moved.close_file();
+  REQUIRE(limit.num_open() == 0);
+
+  // a file that isn't there is only found out when it is read
+  BufferedFileReader missing("./test_files/missing.txt", " ",
+                             BufferedFileReader::Lazy{});
+  REQUIRE(missing.good());
+  REQUIRE_FALSE(missing.get_token().has_value());
+  REQUIRE_FALSE(missing.good());
+  missing.open_file(kHelloFileName);
+  REQUIRE(missing.get_token() == "Hello");
+}
+
+TEST_CASE("access_hints", "[Test_BufferedFileReader]") {
+  BufferedFileReader bf(kLongFileName);
+  REQUIRE(bf.advise(AccessPattern::kSequential));
+  REQUIRE(bf.will_need(0, 0));
+  REQUIRE(bf.dont_need(0, 4096));
+  REQUIRE(bf.get_token() == "The");
+
+  // hints don't change what is read
+  BufferedFileReader expected(kLongFileName);
+  BufferedFileReader dropping(kLongFileName);
+  dropping.advise(AccessPattern::kRandom);
+  dropping.set_drop_behind(true);
+  for (optional<string> token = expected.get_token(); token.has_value();
+       token = expected.get_token()) {
+    REQUIRE(dropping.get_token() == token);
+  }
+  REQUIRE_FALSE(dropping.get_token().has_value());
+
+  // nothing to advise once closed, but the pattern is kept
+  dropping.close_file();
+  REQUIRE_FALSE(dropping.advise(AccessPattern::kSequential));
+  REQUIRE_FALSE(dropping.will_need(0, 0));
+  dropping.open_file(kLongFileName);
+  REQUIRE(dropping.get_token() == "The");
+
+  // a whole pass with drop-behind leaves none of the file cached, if
+  // the file system drops pages at all (tmpfs can't)
+  dropping.rewind();
+  REQUIRE(bf.will_need(0, 0));
+  REQUIRE(bf.dont_need(0, 0));
+  if (resident_pages(kLongFileName) == 0) {
+    while (dropping.get_token().has_value()) {
+    }
+    dropping.close_file();
+    REQUIRE(resident_pages(kLongFileName) == 0);
+  }
+}
+
+TEST_CASE("direct", "[Test_BufferedFileReader]") {
+  // a file that doesn't end on a page boundary
+  char fname[] = "/tmp/directXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  string contents;
+  for (int i = 0; contents.length() < 300000; i++) {
+    contents += to_string(i) + (i % 10 == 9 ? "\n" : " ");
+  }
+  contents += "tail";
+  REQUIRE(write(fd, contents.data(), contents.length()) ==
+          static_cast<ssize_t>(contents.length()));
+  close(fd);
+
+  // small odd sized buffers, so tokens and lines straddle reads
+  BufferedFileReader bf(fname, " \n", BufferedFileReader::Direct{5000});
+  // /tmp may be a tmpfs, which has no O_DIRECT; the reader then
+  // reads normally, which the rest of the test checks instead
+  if (!bf.direct()) {
+    WARN("O_DIRECT is not supported for " << fname);
+  }
+  REQUIRE(bf.good());
+  REQUIRE(bf.tell() == 0);
+  REQUIRE(bf.get_line() ==
+          vector<string>{"0", "1", "2", "3", "4", "5", "6", "7", "8", "9"});
+  off_t offset = bf.tell();
+  for (optional<string> token = bf.get_token(); token.has_value();
+       token = bf.get_token()) {
+    REQUIRE(verify_token(token.value(), contents, " \n", &offset));
+    REQUIRE(bf.tell() == offset);
+  }
+  REQUIRE_FALSE(bf.good());
+  REQUIRE(static_cast<size_t>(bf.tell()) == contents.length());
+
+  // unaligned seeks, and seeks into the tail
+  off_t middle = contents.find(" 12345 ") + 1;
+  REQUIRE(bf.seek(middle));
+  REQUIRE(bf.tell() == middle);
+  REQUIRE(bf.get_token() == "12345");
+  REQUIRE(bf.seek(contents.length() - 2));
+  REQUIRE(bf.get_token() == "il");
+  REQUIRE_FALSE(bf.get_token().has_value());
+  REQUIRE(bf.rewind());
+  REQUIRE(bf.get_char() == '0');
+
+  // sizes are rounded up to whole pages, and capped below 2 GiB, so
+  // buffer indices and single reads stay in range
+  REQUIRE(BufferedFileReader::direct_buffer_size(0) == 4096);
+  REQUIRE(BufferedFileReader::direct_buffer_size(5000) == 8192);
+  REQUIRE(BufferedFileReader::direct_buffer_size(8192) == 8192);
+  REQUIRE(BufferedFileReader::direct_buffer_size(size_t{3} << 30) ==
+          0x7ffff000);
+  REQUIRE(BufferedFileReader::direct_buffer_size(SIZE_MAX) == 0x7ffff000);
+
+  // another file opened by the same reader is read the same way
+  bf.open_file(kLongFileName);
+  BufferedFileReader expected(kLongFileName);
+  for (int i = 0; i < 10000; i++) {
+    REQUIRE(bf.get_token() == expected.get_token());
+  }
+  unlink(fname);
+}
+
+TEST_CASE("huge_pages", "[Test_BufferedFileReader]") {
+  // big allocations are lined up with huge pages, small ones aren't
+  // changed
+  constexpr size_t kPageSize = 4096;
+  AlignedAllocator<char> allocator(kPageSize, true);
+  vector<char, AlignedAllocator<char>> big(3 * kHugePageSize, 'x', allocator);
+  REQUIRE(reinterpret_cast<uintptr_t>(big.data()) % kHugePageSize == 0);
+  big.back() = 'y';
+  REQUIRE(big.at(big.size() - 2) == 'x');
+  vector<char, AlignedAllocator<char>> small(100, 'x', allocator);
+  REQUIRE(reinterpret_cast<uintptr_t>(small.data()) % kPageSize == 0);
+
+  // a reader's buffer in huge pages reads just the same
+  BufferedFileReader expected(kLongFileName);
+  BufferedFileReader bf(kLongFileName, "\r\n\t ",
+                        BufferedFileReader::Direct{kHugePageSize, true});
+  for (optional<string> token = expected.get_token(); token.has_value();
+       token = expected.get_token()) {
+    REQUIRE(bf.get_token() == token);
+  }
+  REQUIRE_FALSE(bf.get_token().has_value());
+}
+
+TEST_CASE("forward", "[Test_BufferedFileReader]") {
+  // records with a header token and a body, some longer than the
+  // buffer, and one longer than FORWARD_SCAN_SIZE
+  char fname[] = "/tmp/forwardXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  vector<string> bodies;
+  for (size_t length : {10, 3000, 1, 100000, 2500000, 20}) {
+    string body;
+    for (size_t i = 0; body.length() < length; i++) {
+      body += to_string(i) + ' ';
+    }
+    bodies.push_back(body + "\n");
+  }
+  string contents;
+  for (size_t i = 0; i < bodies.size(); i++) {
+    contents += "header" + to_string(i) + " " + bodies[i];
+  }
+  contents += "header6 no newline";
+  REQUIRE(write(fd, contents.data(), contents.length()) ==
+          static_cast<ssize_t>(contents.length()));
+  close(fd);
+
+  // the header is read as a token, the body is forwarded to a file
+  char out_name[] = "/tmp/forward_outXXXXXX";
+  int out_fd = mkstemp(out_name);
+  REQUIRE(out_fd >= 0);
+  BufferedFileReader bf(fname, " \n");
+  string expected;
+  for (size_t i = 0; i < bodies.size(); i++) {
+    REQUIRE(bf.get_token() == "header" + to_string(i));
+    off_t body_start = bf.tell();
+    REQUIRE(bf.forward_line_to(out_fd) ==
+            static_cast<ssize_t>(bodies[i].length()));
+    REQUIRE(bf.tell() ==
+            body_start + static_cast<off_t>(bodies[i].length()));
+    expected += bodies[i];
+  }
+  REQUIRE(bf.get_token() == "header6");
+  REQUIRE(bf.forward_line_to(out_fd) == 10);
+  REQUIRE(bf.forward_line_to(out_fd) == 0);
+  REQUIRE_FALSE(bf.good());
+  expected += "no newline";
+
+  // copying a range doesn't move the reader
+  REQUIRE(bf.rewind());
+  REQUIRE(bf.get_token() == "header0");
+  REQUIRE(bf.copy_range_to(out_fd, 1, 5) == 5);
+  REQUIRE(bf.copy_range_to(out_fd, contents.length() - 4, 100) == 4);
+  REQUIRE(bf.get_token() == "0");
+  expected += contents.substr(1, 5) + "line";
+  struct stat st {};
+  REQUIRE(fstat(out_fd, &st) == 0);
+  REQUIRE(static_cast<size_t>(st.st_size) == expected.length());
+  string written(expected.length(), '\0');
+  REQUIRE(pread(out_fd, written.data(), written.length(), 0) ==
+          static_cast<ssize_t>(written.length()));
+  REQUIRE(written == expected);
+  close(out_fd);
+  unlink(out_name);
+
+  // forwarding into a pipe, drained by another thread
+  int pipe_fds[2];
+  REQUIRE(pipe(pipe_fds) == 0);
+  string drained;
+  thread drainer([&]() {
+    char chunk[4096];
+    ssize_t n;
+    while ((n = read(pipe_fds[0], chunk, sizeof(chunk))) > 0) {
+      drained.append(chunk, n);
+    }
+  });
+  REQUIRE(bf.rewind());
+  for (size_t i = 0; i < bodies.size(); i++) {
+    REQUIRE(bf.get_token() == "header" + to_string(i));
+    REQUIRE(bf.forward_line_to(pipe_fds[1]) ==
+            static_cast<ssize_t>(bodies[i].length()));
+  }
+  close(pipe_fds[1]);
+  drainer.join();
+  close(pipe_fds[0]);
+  REQUIRE(drained == expected.substr(0, drained.length()));
+  REQUIRE(drained.length() == contents.find("header6") - 6 * 8);
+
+  // a small file that was read whole is forwarded from the buffer
+  char small_out[] = "/tmp/forward_smallXXXXXX";
+  out_fd = mkstemp(small_out);
+  REQUIRE(out_fd >= 0);
+  // (Hello.txt is one line with no '\n')
+  BufferedFileReader small(kHelloFileName);
+  REQUIRE(small.forward_line_to(out_fd) == 12);
+  REQUIRE(small.copy_range_to(out_fd, 6, 100) == 6);
+  string hello(18, '\0');
+  REQUIRE(pread(out_fd, hello.data(), hello.length(), 0) == 18);
+  REQUIRE(hello == "Hello World!World!");
+  close(out_fd);
+  unlink(small_out);
+  unlink(fname);
+}
+
+TEST_CASE("checkpoint", "[Test_BufferedFileReader]") {
+  BufferedFileReader bf(kLongFileName, " \n");
+  for (int i = 0; i < 50000; i++) {
+    bf.get_token();
+  }
+  optional<string> blob = bf.checkpoint();
+  REQUIRE(blob.has_value());
+  off_t offset = bf.tell();
+  vector<optional<string>> expected;
+  for (int i = 0; i < 1000; i++) {
+    expected.push_back(bf.get_token());
+  }
+
+  // a new reader, with other delimiters, carries on from the same place
+  BufferedFileReader resumed(kHelloFileName, "x");
+  REQUIRE(resumed.resume(blob.value()));
+  REQUIRE(resumed.good());
+  REQUIRE(resumed.tell() == offset);
+  for (const optional<string>& token : expected) {
+    REQUIRE(resumed.get_token() == token);
+  }
+  REQUIRE(resumed.get_line() == bf.get_line());
+
+  // and so does a lazy one, from another directory
+  BufferedFileReader lazy(kHelloFileName, "", BufferedFileReader::Lazy{});
+  char cwd[PATH_MAX];
+  REQUIRE(getcwd(cwd, sizeof(cwd)) != nullptr);
+  REQUIRE(chdir("/") == 0);
+  bool resumed_lazy = lazy.resume(blob.value());
+  REQUIRE(chdir(cwd) == 0);
+  REQUIRE(resumed_lazy);
+  REQUIRE(lazy.get_token() == expected.at(0));
+
+  // multi-char delimiters, checkpointed part way through a delimiter
+  // (get_char() doesn't match delimiters, so nothing is matched yet)
+  char fname[] = "/tmp/checkpointXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  string contents;
+  for (int i = 0; i < 20000; i++) {
+    contents += to_string(i) + (i % 3 == 0 ? "<SEP>" : "||");
+  }
+  REQUIRE(write(fd, contents.data(), contents.length()) ==
+          static_cast<ssize_t>(contents.length()));
+  close(fd);
+  vector<string> delims{"<SEP>", "||"};
+  BufferedFileReader multi(fname, delims);
+  for (int i = 0; i < 10000; i++) {
+    multi.get_token();
+  }
+  multi.get_char();
+  multi.get_char();  // "<S"
+  blob = multi.checkpoint();
+  REQUIRE(blob.has_value());
+  BufferedFileReader multi_resumed(kHelloFileName);
+  REQUIRE(multi_resumed.resume(blob.value()));
+  REQUIRE(multi_resumed.tell() == multi.tell());
+  for (int i = 0; i < 5000; i++) {
+    REQUIRE(multi_resumed.get_token() == multi.get_token());
+  }
+
+  // a file that changed since can't be resumed from
+  fd = open(fname, O_WRONLY | O_APPEND);
+  REQUIRE(write(fd, "more", 4) == 4);
+  close(fd);
+  REQUIRE_FALSE(multi_resumed.resume(blob.value()));
+  REQUIRE(multi_resumed.get_token() == multi.get_token());
+  unlink(fname);
+  REQUIRE_FALSE(multi_resumed.resume(blob.value()));
+
+  // nor can a blob that isn't a checkpoint, or is cut short
+  REQUIRE_FALSE(resumed.resume(""));
+  REQUIRE_FALSE(resumed.resume("not a checkpoint"));
+  optional<string> good_blob = resumed.checkpoint();
+  REQUIRE(good_blob.has_value());
+  for (size_t length = 0; length < good_blob->length(); length++) {
+    REQUIRE_FALSE(
+        resumed.resume(string_view(good_blob.value()).substr(0, length)));
+  }
+  REQUIRE(resumed.resume(good_blob.value()));
+  // nor one from an older version of the format
+  string old_blob = good_blob.value();
+  old_blob[4] = '1';
+  REQUIRE_FALSE(resumed.resume(old_blob));
+
+  // a small file read whole, at the end
+  BufferedFileReader small(kHelloFileName);
+  while (small.get_token().has_value()) {
+  }
+  blob = small.checkpoint();
+  REQUIRE(blob.has_value());
+  REQUIRE(resumed.resume(blob.value()));
+  REQUIRE(resumed.tell() == small.tell());
+  REQUIRE_FALSE(resumed.get_token().has_value());
+
+  // there is nothing to resume a reader of a pipe or a descriptor from
+  BufferedFileReader from_fd(open(kHelloFileName, O_RDONLY));
+  REQUIRE_FALSE(from_fd.checkpoint().has_value());
+  from_fd.close_file();
+  REQUIRE_FALSE(from_fd.checkpoint().has_value());
+}
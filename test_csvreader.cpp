@@ -0,0 +1,130 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./CsvReader.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+// helper functions
+
+// Writes contents to a new temporary file and returns its name
+static string write_temp_file(const string& contents) {
+  char fname[] = "/tmp/csv_readerXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  REQUIRE(write(fd, contents.data(), contents.length()) ==
+          static_cast<ssize_t>(contents.length()));
+  close(fd);
+  return fname;
+}
+
+// Returns the CSV encoding of a field, quoting it only if it has to be
+static string encode_field(const string& field, char separator) {
+  if (field.find_first_of(string{separator, '"', '\n', '\r'}) ==
+      string::npos) {
+    return field;
+  }
+  string encoded = "\"";
+  for (char c : field) {
+    encoded += c;
+    if (c == '"') {
+      encoded += '"';
+    }
+  }
+  return encoded + "\"";
+}
+
+// Reads every record of the file and compares it against expected
+static void check_records(const string& fname,
+                          char separator,
+                          const vector<vector<string>>& expected) {
+  BufferedFileReader bf(fname);
+  CsvReader csv(bf, separator);
+
+  for (const vector<string>& record : expected) {
+    optional<span<const string_view>> opt = csv.get_record();
+    REQUIRE(opt.has_value());
+    REQUIRE(opt.value().size() == record.size());
+    for (size_t i = 0; i < record.size(); i++) {
+      REQUIRE(opt.value()[i] == record.at(i));
+    }
+  }
+  REQUIRE_FALSE(csv.get_record().has_value());
+  REQUIRE_FALSE(bf.good());
+}
+
+TEST_CASE("Basic", "[Test_CsvReader]") {
+  string fname = write_temp_file(
+      "id,name,comment\n"
+      "1,\"Smith, John\",\"said \"\"hi\"\"\ntwice\"\r\n"
+      "\n"
+      ",,\n"
+      "2,plain,\"\"\n"
+      "3,no newline at the end");
+
+  check_records(fname, ',',
+                {{"id", "name", "comment"},
+                 {"1", "Smith, John", "said \"hi\"\ntwice"},
+                 {""},
+                 {"", "", ""},
+                 {"2", "plain", ""},
+                 {"3", "no newline at the end"}});
+  unlink(fname.c_str());
+}
+
+TEST_CASE("TSV", "[Test_CsvReader]") {
+  string fname = write_temp_file("a\tb,c\t\"d\te\"\n\"x\"\"\"\ty\n");
+
+  check_records(fname, '\t', {{"a", "b,c", "d\te"}, {"x\"", "y"}});
+  unlink(fname.c_str());
+}
+
+TEST_CASE("Generated", "[Test_CsvReader]") {
+  // Fields of every kind and many lengths, so that quotes, separators
+  // and newlines land on every position of a 16 byte block and on both
+  // sides of a buffer refill.
+  vector<string> pieces = {"plain", "with,comma", "with\nnewline",
+                           "with \"quotes\"", "", "\"", "\"\"", ",\n,",
+                           string(2000, 'L'), "x\r"};
+  vector<vector<string>> expected;
+  string contents;
+  srand(5950);
+  for (int i = 0; i < 2000; i++) {
+    vector<string> record;
+    int num_fields = 1 + rand() % 6;
+    for (int j = 0; j < num_fields; j++) {
+      string field = string(rand() % 20, 'a' + j) +
+                     pieces.at(rand() % pieces.size()) +
+                     string(rand() % 3, 'z');
+      if (rand() % 50 != 0) {
+        field.resize(min<size_t>(field.size(), 100));
+      }
+      record.push_back(field);
+      contents += encode_field(field, ',');
+      contents += j + 1 < num_fields ? "," : (i % 3 == 0 ? "\r\n" : "\n");
+    }
+    expected.push_back(record);
+  }
+
+  string fname = write_temp_file(contents);
+  check_records(fname, ',', expected);
+  unlink(fname.c_str());
+}
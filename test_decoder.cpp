@@ -0,0 +1,303 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./Decoder.hpp"
+#include "./catch.hpp"
+
+#if __has_include(<zlib.h>)
+#include <zlib.h>
+#endif
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+// helper functions
+
+static string read_contents(const char* fname) {
+  ifstream ifs(fname);
+  return string((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+}
+
+// Writes contents to a new temporary file, returning its name
+static string write_temp(const string& contents) {
+  char fname[] = "/tmp/decoderXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  REQUIRE(write(fd, contents.data(), contents.length()) ==
+          static_cast<ssize_t>(contents.length()));
+  close(fd);
+  return fname;
+}
+
+// Reads every token of the file
+static vector<string> all_tokens(BufferedFileReader& bf) {
+  vector<string> tokens;
+  optional<string> opt = bf.get_token();
+  while (opt.has_value()) {
+    tokens.push_back(opt.value());
+    opt = bf.get_token();
+  }
+  return tokens;
+}
+
+// A codec that takes all of its input at once, but hands it back
+// unchanged at most kStep bytes at a time, so it is still holding output
+// back after the last of the input is taken (as zstd can be)
+class HoldingCodec : public Codec {
+ public:
+  explicit HoldingCodec(bool complete) : complete_(complete) {}
+
+  bool decode(string_view* in, string* out, size_t max_out) override {
+    held_.append(*in);
+    in->remove_prefix(in->size());
+    size_t n = min({held_.size() - pos_, max_out, kStep});
+    out->append(held_, pos_, n);
+    pos_ += n;
+    return true;
+  }
+
+  bool finished() const override { return complete_ && pos_ == held_.size(); }
+
+ private:
+  static constexpr size_t kStep = 1000;
+
+  string held_;     // every byte taken so far
+  size_t pos_ = 0;  // how much of held_ has been handed back
+  bool complete_;   // whether to say the stream ended properly
+};
+
+// Reads everything the decoder gives back, and the result of the last read
+static string read_all(Decoder& decoder, ssize_t* last) {
+  string result;
+  char buf[4096];
+  while ((*last = decoder.read(buf, sizeof(buf))) > 0) {
+    result.append(buf, *last);
+  }
+  return result;
+}
+
+#if __has_include(<zlib.h>)
+// Compresses contents into a single gzip member
+static string gzip(const string& contents) {
+  z_stream stream{};
+  REQUIRE(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16,
+                       8, Z_DEFAULT_STRATEGY) == Z_OK);
+  string out(deflateBound(&stream, contents.length()), '\0');
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(contents.data()));
+  stream.avail_in = contents.length();
+  stream.next_out = reinterpret_cast<Bytef*>(out.data());
+  stream.avail_out = out.length();
+  REQUIRE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+  out.resize(stream.total_out);
+  deflateEnd(&stream);
+  return out;
+}
+
+TEST_CASE("gzip", "[Test_Decoder]") {
+  string contents = read_contents(kLongFileName);
+  string compressed = gzip(contents);
+  REQUIRE(compressed.length() < contents.length() / 2);
+  string fname = write_temp(compressed);
+
+  BufferedFileReader plain(kLongFileName);
+  BufferedFileReader bf(fname);
+  REQUIRE(bf.good());
+  REQUIRE_FALSE(bf.seekable());
+  vector<string> expected = all_tokens(plain);
+  REQUIRE(all_tokens(bf) == expected);
+  REQUIRE_FALSE(bf.good());
+  REQUIRE(bf.tell() == plain.tell());
+
+  // rewinding decompresses again from the start
+  REQUIRE(bf.rewind());
+  REQUIRE(bf.get_token() == expected.at(0));
+  REQUIRE(plain.rewind());
+  plain.get_token();
+  REQUIRE(bf.get_line() == plain.get_line());
+  REQUIRE_FALSE(bf.seek(static_cast<off_t>(contents.length() / 2)));
+
+  // closed part way through, with the helper thread still going
+  bf.rewind();
+  bf.get_char();
+  bf.close_file();
+  REQUIRE_FALSE(bf.good());
+  unlink(fname.c_str());
+}
+
+TEST_CASE("gzip_checkpoint", "[Test_Decoder]") {
+  // resuming decompresses up to the checkpoint again
+  string fname = write_temp(gzip(read_contents(kLongFileName)));
+  BufferedFileReader bf(fname);
+  for (int i = 0; i < 100000; i++) {
+    bf.get_token();
+  }
+  optional<string> blob = bf.checkpoint();
+  REQUIRE(blob.has_value());
+  BufferedFileReader resumed(kHelloFileName);
+  REQUIRE(resumed.resume(blob.value()));
+  REQUIRE(resumed.tell() == bf.tell());
+  REQUIRE(all_tokens(resumed) == all_tokens(bf));
+  unlink(fname.c_str());
+}
+
+TEST_CASE("gzip_direct", "[Test_Decoder]") {
+  // a reader in O_DIRECT mode reads a compressed file normally
+  string contents = read_contents(kLongFileName);
+  string fname = write_temp(gzip(contents));
+  BufferedFileReader plain(kLongFileName);
+  BufferedFileReader bf(fname, "\r\n\t ", BufferedFileReader::Direct{});
+  REQUIRE_FALSE(bf.direct());
+  vector<string> expected = all_tokens(plain);
+  REQUIRE(all_tokens(bf) == expected);
+  REQUIRE(bf.rewind());
+  REQUIRE(bf.get_token() == expected.at(0));
+  unlink(fname.c_str());
+}
+
+TEST_CASE("gzip_members", "[Test_Decoder]") {
+  // several members back to back read as one file
+  string contents = read_contents(kLongFileName);
+  size_t half = contents.length() / 2;
+  string fname =
+      write_temp(gzip(contents.substr(0, half)) + gzip(contents.substr(half)));
+  BufferedFileReader plain(kLongFileName);
+  BufferedFileReader bf(fname);
+  REQUIRE(all_tokens(bf) == all_tokens(plain));
+  unlink(fname.c_str());
+
+  // a tiny file, smaller than the buffer
+  fname = write_temp(gzip(read_contents(kHelloFileName)));
+  BufferedFileReader hello(fname);
+  REQUIRE(hello.get_token() == "Hello");
+  unlink(fname.c_str());
+}
+
+TEST_CASE("gzip_pipe", "[Test_Decoder]") {
+  string contents = read_contents(kLongFileName);
+  string compressed = gzip(contents);
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  // (catch assertions are not thread safe, so the writer only
+  // records whether its writes worked)
+  bool wrote = true;
+  thread writer([fd = fds[1], &compressed, &wrote]() {
+    for (size_t i = 0; i < compressed.length(); i += 5000) {
+      string piece = compressed.substr(i, 5000);
+      wrote = wrote && write(fd, piece.data(), piece.length()) ==
+                           static_cast<ssize_t>(piece.length());
+    }
+    close(fd);
+  });
+
+  BufferedFileReader plain(kLongFileName);
+  BufferedFileReader bf(fds[0]);
+  REQUIRE(all_tokens(bf) == all_tokens(plain));
+  REQUIRE(static_cast<size_t>(bf.tell()) == contents.length());
+  REQUIRE_FALSE(bf.rewind());
+  writer.join();
+  REQUIRE(wrote);
+}
+
+TEST_CASE("gzip_corrupt", "[Test_Decoder]") {
+  string contents = read_contents(kLongFileName);
+  string compressed = gzip(contents);
+
+  // cut short: everything that could be decompressed is read,
+  // then the reader stops
+  string fname = write_temp(compressed.substr(0, compressed.length() / 2));
+  BufferedFileReader truncated(fname);
+  vector<string> tokens = all_tokens(truncated);
+  REQUIRE_FALSE(truncated.good());
+  REQUIRE(static_cast<size_t>(truncated.tell()) < contents.length());
+  unlink(fname.c_str());
+
+  // garbage after the magic bytes
+  fname = write_temp(string("\x1f\x8b") + string(5000, 'x'));
+  BufferedFileReader garbage(fname);
+  REQUIRE_FALSE(garbage.get_token().has_value());
+  REQUIRE_FALSE(garbage.good());
+  unlink(fname.c_str());
+}
+#endif  // __has_include(<zlib.h>)
+
+#if __has_include(<zstd.h>)
+TEST_CASE("zstd", "[Test_Decoder]") {
+  string contents = read_contents(kLongFileName);
+  string compressed(ZSTD_compressBound(contents.length()), '\0');
+  size_t size = ZSTD_compress(compressed.data(), compressed.length(),
+                              contents.data(), contents.length(), 3);
+  REQUIRE_FALSE(ZSTD_isError(size));
+  compressed.resize(size);
+  string fname = write_temp(compressed);
+
+  BufferedFileReader plain(kLongFileName);
+  BufferedFileReader bf(fname);
+  REQUIRE(all_tokens(bf) == all_tokens(plain));
+  unlink(fname.c_str());
+}
+#endif  // __has_include(<zstd.h>)
+
+TEST_CASE("held_back_output", "[Test_Decoder]") {
+  // the output held back once the input has all been read is not lost
+  string contents = read_contents(kLongFileName).substr(0, 300000);
+  string fname = write_temp(contents);
+  int fd = open(fname.c_str(), O_RDONLY);
+  REQUIRE(fd >= 0);
+  ssize_t last = 0;
+  {
+    Decoder decoder(fd, "", make_unique<HoldingCodec>(true));
+    REQUIRE(read_all(decoder, &last) == contents);
+    REQUIRE(last == 0);
+  }
+
+  // and a stream that doesn't end properly is still an error,
+  // after everything it did decode
+  REQUIRE(lseek(fd, 0, SEEK_SET) == 0);
+  {
+    Decoder decoder(fd, "", make_unique<HoldingCodec>(false));
+    REQUIRE(read_all(decoder, &last) == contents);
+    REQUIRE(last == -1);
+  }
+  close(fd);
+  unlink(fname.c_str());
+}
+
+TEST_CASE("make_codec", "[Test_Decoder]") {
+  REQUIRE(Decoder::make_codec("Hello") == nullptr);
+  REQUIRE(Decoder::make_codec("") == nullptr);
+  REQUIRE(Decoder::make_codec("\x1f") == nullptr);
+#if __has_include(<zlib.h>)
+  REQUIRE(Decoder::make_codec("\x1f\x8b\x08") != nullptr);
+#endif
+
+  // plain files are read as they are
+  BufferedFileReader bf(kHelloFileName);
+  REQUIRE(bf.seekable());
+  REQUIRE(bf.get_token() == "Hello");
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./LineBatch.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+static constexpr const char* kGreatFileName = "./test_files/mutual_aid.txt";
+
+// Reads the whole file in batches and checks every line against get_line()
+static void check_batches(const char* fname,
+                          const string& delims,
+                          size_t max_lines,
+                          size_t max_bytes) {
+  BufferedFileReader bf(fname, delims);
+  BufferedFileReader expected_bf(fname, delims);
+  optional<vector<string>> opt{};
+  LineBatch batch;
+
+  while (batch.read(bf, max_lines, max_bytes) > 0) {
+    REQUIRE(batch.num_lines() <= max_lines);
+    // only the last line may push the batch over max_bytes
+    if (batch.num_lines() > 1) {
+      size_t last = batch.line_starts().at(batch.num_lines() - 1);
+      size_t before_last =
+          last == batch.num_tokens() ? batch.num_bytes()
+                                     : batch.token_offsets().at(last);
+      REQUIRE(before_last < max_bytes);
+    }
+
+    for (size_t line = 0; line < batch.num_lines(); line++) {
+      opt = expected_bf.get_line();
+      REQUIRE(opt.has_value());
+      REQUIRE(batch.line_size(line) == opt.value().size());
+      for (size_t i = 0; i < batch.line_size(line); i++) {
+        REQUIRE(batch.token(line, i) == opt.value().at(i));
+      }
+    }
+    REQUIRE(bf.tell() == expected_bf.tell());
+  }
+
+  REQUIRE_FALSE(expected_bf.get_line().has_value());
+  REQUIRE(batch.num_lines() == 0);
+  REQUIRE(batch.num_tokens() == 0);
+}
+
+TEST_CASE("Basic", "[Test_LineBatch]") {
+  BufferedFileReader bf(kByeFileName, ",\t ");
+  LineBatch batch;
+
+  REQUIRE(batch.num_lines() == 0);
+  REQUIRE(batch.read(bf, 1000, 1000) > 0);
+  REQUIRE(batch.num_lines() > 0);
+  REQUIRE_FALSE(bf.good());
+
+  // tokens are packed back to back in the arena
+  size_t offset = 0;
+  for (size_t i = 0; i < batch.num_tokens(); i++) {
+    REQUIRE(batch.token_offsets().at(i) == offset);
+    offset += batch.token_lengths().at(i);
+  }
+  REQUIRE(offset == batch.num_bytes());
+  REQUIRE(batch.line_starts().back() == batch.num_tokens());
+
+  batch.clear();
+  REQUIRE(batch.num_lines() == 0);
+  REQUIRE(batch.num_tokens() == 0);
+  REQUIRE(batch.num_bytes() == 0);
+  REQUIRE(batch.read(bf, 1000, 1000) == 0);
+}
+
+TEST_CASE("line_limit", "[Test_LineBatch]") {
+  check_batches(kByeFileName, ",\t ", 1, 1 << 20);
+  check_batches(kGreatFileName, ",\t ", 7, 1 << 20);
+  check_batches(kGreatFileName, "\t ", 1000, 1 << 20);
+}
+
+TEST_CASE("byte_limit", "[Test_LineBatch]") {
+  check_batches(kGreatFileName, ",\t ", 1 << 20, 1);
+  check_batches(kGreatFileName, ",\t ", 1 << 20, 4096);
+  check_batches(kGreatFileName, ",\n ", 50, 1000);
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./LineBatch.hpp"
+#include "./LineDispatcher.hpp"
+#include "./MpmcQueue.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+// helper functions
+
+// The work done on each batch: the number of tokens
+// and the longest token of every line
+static void describe_lines(const LineBatch& batch, string* out) {
+  for (size_t line = 0; line < batch.num_lines(); line++) {
+    string_view longest;
+    for (size_t i = 0; i < batch.line_size(line); i++) {
+      if (batch.token(line, i).size() > longest.size()) {
+        longest = batch.token(line, i);
+      }
+    }
+    *out += to_string(batch.line_size(line)) + " " + string(longest) + "\n";
+  }
+}
+
+// Splits text into its lines
+static vector<string> lines_of(const string& text) {
+  vector<string> lines;
+  size_t start = 0;
+  for (size_t end = text.find('\n'); end != string::npos;
+       end = text.find('\n', start)) {
+    lines.push_back(text.substr(start, end - start));
+    start = end + 1;
+  }
+  return lines;
+}
+
+TEST_CASE("MpmcQueue", "[Test_LineDispatcher]") {
+  MpmcQueue<int> queue(3);
+  REQUIRE(queue.capacity() == 4);
+  int item = 0;
+  REQUIRE_FALSE(queue.try_pop(item));
+  for (int i = 0; i < 4; i++) {
+    item = i;
+    REQUIRE(queue.try_push(item));
+  }
+  item = 4;
+  REQUIRE_FALSE(queue.try_push(item));
+  for (int i = 0; i < 4; i++) {
+    REQUIRE(queue.try_pop(item));
+    REQUIRE(item == i);
+  }
+
+  // several producers and consumers at once: every item comes out once
+  constexpr int kThreads = 3;
+  constexpr int kPerThread = 20000;
+  vector<thread> threads;
+  vector<vector<int>> popped(kThreads);
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&queue, t]() {
+      for (int i = 0; i < kPerThread; i++) {
+        queue.push(t * kPerThread + i);
+      }
+    });
+    threads.emplace_back([&queue, &popped, t]() {
+      for (int i = 0; i < kPerThread; i++) {
+        popped[t].push_back(queue.pop());
+      }
+    });
+  }
+  for (thread& thread : threads) {
+    thread.join();
+  }
+  vector<int> all;
+  for (const vector<int>& items : popped) {
+    // each producer's items stay in order
+    for (size_t i = 1; i < items.size(); i++) {
+      if (items[i] / kPerThread == items[i - 1] / kPerThread) {
+        REQUIRE(items[i] > items[i - 1]);
+      }
+    }
+    all.insert(all.end(), items.begin(), items.end());
+  }
+  sort(all.begin(), all.end());
+  REQUIRE(all.size() == kThreads * kPerThread);
+  for (int i = 0; i < kThreads * kPerThread; i++) {
+    REQUIRE(all[i] == i);
+  }
+}
+
+TEST_CASE("LineDispatcher", "[Test_LineDispatcher]") {
+  // the output of a single thread doing all of the work
+  BufferedFileReader bf(kLongFileName);
+  LineBatch batch;
+  string expected;
+  uint64_t expected_lines = 0;
+  while (batch.read(bf, 1000, SIZE_MAX) > 0) {
+    expected_lines += batch.num_lines();
+    describe_lines(batch, &expected);
+  }
+
+  for (size_t num_workers : {1, 4}) {
+    string ordered_out;
+    LineDispatcher ordered(
+        num_workers, describe_lines,
+        [&ordered_out](string_view out) { ordered_out += out; }, true, 64,
+        4);
+    REQUIRE(ordered.run(kLongFileName) == expected_lines);
+    REQUIRE(ordered_out == expected);
+
+    // unordered, the same lines come out in batches in any order
+    string unordered_out;
+    LineDispatcher unordered(
+        num_workers, describe_lines,
+        [&unordered_out](string_view out) { unordered_out += out; }, false,
+        64, 4);
+    REQUIRE(unordered.run(kLongFileName) == expected_lines);
+    vector<string> lines = lines_of(unordered_out);
+    vector<string> expected_sorted = lines_of(expected);
+    sort(lines.begin(), lines.end());
+    sort(expected_sorted.begin(), expected_sorted.end());
+    REQUIRE(lines == expected_sorted);
+
+    // and it can be run again
+    unordered_out.clear();
+    REQUIRE(unordered.run(kLongFileName) == expected_lines);
+    REQUIRE(unordered_out.length() == expected.length());
+  }
+
+  LineDispatcher missing(2, describe_lines, [](string_view /* out */) {});
+  REQUIRE(missing.run("/tmp/does/not/exist") == 0);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./LineIndex.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+// helper functions
+
+// Reads the file front to back, returning the offset each line starts at
+static vector<off_t> line_offsets(const char* fname) {
+  BufferedFileReader bf(fname);
+  vector<off_t> offsets;
+  off_t size = 0;
+  while (bf.good()) {
+    offsets.push_back(bf.tell());
+    if (!bf.get_line().has_value()) {
+      offsets.pop_back();
+    }
+    size = bf.tell();
+  }
+  // a last line without a '\n' is dropped by get_line()
+  if (!offsets.empty() && offsets.back() == size) {
+    offsets.pop_back();
+  }
+  return offsets;
+}
+
+// Seeks to every line in order and to a few random lines,
+// checking that get_line() starts at the right offset
+static void check_index(const LineIndex& index,
+                        const char* fname,
+                        const vector<off_t>& offsets) {
+  BufferedFileReader bf(fname);
+  REQUIRE(index.num_lines() >= offsets.size());
+  for (size_t line = 0; line < offsets.size(); line += 7) {
+    REQUIRE(index.seek_to_line(bf, line));
+    REQUIRE(bf.tell() == offsets.at(line));
+  }
+  srand(5950);
+  for (int i = 0; i < 200; i++) {
+    uint64_t line = rand() % offsets.size();
+    BufferedFileReader expected(fname);
+    expected.seek(offsets.at(line));
+
+    REQUIRE(index.seek_to_line(bf, line));
+    REQUIRE(bf.tell() == offsets.at(line));
+    REQUIRE(bf.get_line() == expected.get_line());
+  }
+  REQUIRE_FALSE(index.seek_to_line(bf, index.num_lines()));
+}
+
+TEST_CASE("Basic", "[Test_LineIndex]") {
+  LineIndex index(kHelloFileName, 1);
+  REQUIRE(index.num_lines() == 1);
+  REQUIRE(index.interval() == 1);
+
+  BufferedFileReader bf(kHelloFileName);
+  bf.get_char();
+  REQUIRE(index.seek_to_line(bf, 0));
+  REQUIRE(bf.tell() == 0);
+  REQUIRE('H' == bf.get_char());
+  REQUIRE_FALSE(index.seek_to_line(bf, 1));
+}
+
+TEST_CASE("seek_to_line", "[Test_LineIndex]") {
+  vector<off_t> offsets = line_offsets(kLongFileName);
+  struct stat st {};
+  REQUIRE(stat(kLongFileName, &st) == 0);
+
+  for (uint64_t interval : {1, 3, 100, 1024, 1000000}) {
+    LineIndex index(kLongFileName, interval);
+    REQUIRE(index.file_size() == static_cast<uint64_t>(st.st_size));
+    check_index(index, kLongFileName, offsets);
+  }
+}
+
+TEST_CASE("save_load", "[Test_LineIndex]") {
+  vector<off_t> offsets = line_offsets(kLongFileName);
+  LineIndex index(kLongFileName, 64);
+
+  char fname[] = "/tmp/line_indexXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  close(fd);
+  REQUIRE(index.save(fname));
+
+  // delta encoded: about 2 bytes per checkpoint
+  struct stat st {};
+  REQUIRE(stat(fname, &st) == 0);
+  REQUIRE(static_cast<uint64_t>(st.st_size) <
+          3 * (index.num_lines() / index.interval()) + 32);
+
+  optional<LineIndex> loaded = LineIndex::load(fname);
+  REQUIRE(loaded.has_value());
+  REQUIRE(loaded.value().num_lines() == index.num_lines());
+  REQUIRE(loaded.value().interval() == index.interval());
+  REQUIRE(loaded.value().file_size() == index.file_size());
+  check_index(loaded.value(), kLongFileName, offsets);
+
+  // a header asking for far more checkpoints than the file holds
+  string corrupt = "LIDX0001";
+  for (uint64_t value : {uint64_t{1}, uint64_t{1} << 60, uint64_t{100},
+                         uint64_t{1} << 60}) {
+    for (; value >= 0x80; value >>= 7) {
+      corrupt += static_cast<char>((value & 0x7f) | 0x80);
+    }
+    corrupt += static_cast<char>(value);
+  }
+  corrupt += "\x01\x01";
+  fd = open(fname, O_WRONLY | O_TRUNC);
+  REQUIRE(write(fd, corrupt.data(), corrupt.length()) ==
+          static_cast<ssize_t>(corrupt.length()));
+  close(fd);
+  REQUIRE_FALSE(LineIndex::load(fname).has_value());
+
+  // not an index
+  REQUIRE_FALSE(LineIndex::load(kLongFileName).has_value());
+  REQUIRE_FALSE(LineIndex::load("/tmp/does/not/exist").has_value());
+  unlink(fname);
+}
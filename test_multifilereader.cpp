@@ -0,0 +1,209 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "./MultiFileReader.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+using JoinMode = MultiFileReader::JoinMode;
+
+// helper functions
+
+// Writes each of the pieces to a new temporary file,
+// returning their names
+static vector<string> write_files(const vector<string>& pieces) {
+  vector<string> fnames;
+  for (const string& piece : pieces) {
+    char fname[] = "/tmp/multifileXXXXXX";
+    int fd = mkstemp(fname);
+    REQUIRE(fd >= 0);
+    REQUIRE(write(fd, piece.data(), piece.length()) ==
+            static_cast<ssize_t>(piece.length()));
+    close(fd);
+    fnames.push_back(fname);
+  }
+  return fnames;
+}
+
+static void remove_files(const vector<string>& fnames) {
+  for (const string& fname : fnames) {
+    unlink(fname.c_str());
+  }
+}
+
+// Splits contents into tokens at every delimiter, the way
+// get_token() reads them from a single file
+static vector<string> split(const string& contents, const string& delims) {
+  vector<string> tokens;
+  string token;
+  for (char c : contents) {
+    if (delims.find(c) != string::npos) {
+      tokens.push_back(token);
+      token.clear();
+    } else {
+      token += c;
+    }
+  }
+  if (!token.empty()) {
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+
+TEST_CASE("Basic", "[Test_MultiFileReader]") {
+  vector<string> fnames = write_files({"ab cd", "", "ef\ngh", "ij\n"});
+  fnames.insert(fnames.begin() + 1, "/tmp/does/not/exist");
+
+  // a file boundary ends tokens and lines
+  MultiFileReader separate(fnames, " \n", JoinMode::kSeparate);
+  REQUIRE(separate.good());
+  REQUIRE(separate.get_token() == "ab");
+  REQUIRE(separate.get_token() == "cd");
+  REQUIRE(separate.get_token() == "ef");
+  REQUIRE(separate.file_index() == 3);
+  REQUIRE(separate.get_token() == "gh");
+  REQUIRE(separate.get_token() == "ij");
+  REQUIRE_FALSE(separate.get_token().has_value());
+  REQUIRE_FALSE(separate.good());
+  REQUIRE(separate.file_index() == fnames.size());
+
+  MultiFileReader lines(fnames, " ", JoinMode::kSeparate);
+  REQUIRE(lines.get_line() == vector<string>{"ab", "cd"});
+  REQUIRE(lines.get_line() == vector<string>{"ef"});
+  REQUIRE(lines.get_line() == vector<string>{"gh"});
+  REQUIRE(lines.get_line() == vector<string>{"ij"});
+  REQUIRE_FALSE(lines.get_line().has_value());
+
+  // the files run together
+  MultiFileReader concatenate(fnames, " \n", JoinMode::kConcatenate);
+  REQUIRE(concatenate.get_token() == "ab");
+  REQUIRE(concatenate.get_token() == "cdef");
+  REQUIRE(concatenate.get_token() == "ghij");
+  REQUIRE_FALSE(concatenate.get_token().has_value());
+
+  MultiFileReader joined_lines(fnames, " ", JoinMode::kConcatenate);
+  REQUIRE(joined_lines.get_line() == vector<string>{"ab", "cdef"});
+  REQUIRE(joined_lines.get_line() == vector<string>{"ghij"});
+  REQUIRE_FALSE(joined_lines.get_line().has_value());
+
+  string chars;
+  MultiFileReader char_reader(fnames);
+  for (char c = char_reader.get_char(); c != EOF;
+       c = char_reader.get_char()) {
+    chars += c;
+  }
+  REQUIRE(chars == "ab cdef\nghij\n");
+
+  MultiFileReader empty(vector<string>{});
+  REQUIRE_FALSE(empty.good());
+  REQUIRE(empty.get_char() == EOF);
+  REQUIRE_FALSE(empty.get_line().has_value());
+  remove_files(fnames);
+}
+
+TEST_CASE("segments", "[Test_MultiFileReader]") {
+  ifstream ifs(kLongFileName);
+  string contents((istreambuf_iterator<char>(ifs)),
+                  istreambuf_iterator<char>());
+
+  // cut into many segments at arbitrary points, like a rotated log
+  vector<string> pieces;
+  srand(5950);
+  for (size_t start = 0; start < contents.length();) {
+    size_t length = 1 + rand() % 20000;
+    pieces.push_back(contents.substr(start, length));
+    start += length;
+  }
+  vector<string> fnames = write_files(pieces);
+
+  MultiFileReader tokens(fnames, "\r\n\t ", JoinMode::kConcatenate);
+  vector<string> expected = split(contents, "\r\n\t ");
+  for (const string& token : expected) {
+    REQUIRE(tokens.get_token() == token);
+  }
+  REQUIRE_FALSE(tokens.get_token().has_value());
+
+  // lines are the same as reading the whole file
+  MultiFileReader lines(fnames, " ", JoinMode::kConcatenate);
+  size_t num_lines = 0;
+  size_t line_start = 0;
+  while (line_start < contents.length()) {
+    size_t line_end = contents.find('\n', line_start);
+    optional<vector<string>> opt = lines.get_line();
+    REQUIRE(opt.has_value());
+    vector<string> line =
+        split(contents.substr(line_start, line_end - line_start + 1), " \n");
+    if (line.empty()) {
+      line.push_back("");
+    }
+    REQUIRE(opt.value() == line);
+    line_start = line_end + 1;
+    num_lines++;
+  }
+  REQUIRE_FALSE(lines.get_line().has_value());
+  REQUIRE(num_lines > 60000);
+  remove_files(fnames);
+}
+
+TEST_CASE("reader_delims", "[Test_MultiFileReader]") {
+  // pieces cut inside tokens, but never inside a delimiter string
+  vector<string> pieces{"ab||c", "d<SEP>e\r\nf", "||", "gh\r\n", "i"};
+  vector<string> fnames = write_files(pieces);
+  vector<string> delims{"||", "<SEP>", "\r\n"};
+
+  // the same tokens and lines as one reader over the whole contents
+  vector<string> whole = write_files({"ab||cd<SEP>e\r\nf||gh\r\ni"});
+  MultiFileReader tokens(fnames, delims, JoinMode::kConcatenate);
+  BufferedFileReader bf(whole[0], delims);
+  optional<string> token = bf.get_token();
+  for (; token.has_value(); token = bf.get_token()) {
+    REQUIRE(tokens.get_token() == token);
+  }
+  REQUIRE_FALSE(tokens.get_token().has_value());
+
+  MultiFileReader lines(fnames, delims, JoinMode::kConcatenate);
+  REQUIRE(lines.get_line() == vector<string>{"ab", "cd", "e"});
+  REQUIRE(lines.get_line() == vector<string>{"f", "gh"});
+  REQUIRE(lines.get_line() == vector<string>{"i"});
+  REQUIRE_FALSE(lines.get_line().has_value());
+
+  // the end of each file ends the token
+  MultiFileReader separate(fnames, delims, JoinMode::kSeparate);
+  REQUIRE(separate.get_token() == "ab");
+  REQUIRE(separate.get_token() == "c");
+  REQUIRE(separate.get_token() == "d");
+  REQUIRE(separate.get_token() == "e");
+  REQUIRE(separate.get_token() == "f");
+  REQUIRE(separate.get_token() == "");
+  REQUIRE(separate.get_token() == "gh");
+  REQUIRE(separate.get_token() == "i");
+  REQUIRE_FALSE(separate.get_token().has_value());
+
+  // delimiters fixed at compile time read like the same string
+  MultiFileReader fixed(fnames, Delims<'|', '\n'>{}, JoinMode::kConcatenate);
+  MultiFileReader runtime(fnames, "|\n", JoinMode::kConcatenate);
+  while (runtime.good()) {
+    REQUIRE(fixed.get_line() == runtime.get_line());
+  }
+  REQUIRE_FALSE(fixed.get_line().has_value());
+  remove_files(fnames);
+  remove_files(whole);
+}
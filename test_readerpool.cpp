@@ -0,0 +1,104 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./ReaderPool.hpp"
+#include "./SimpleFileReader.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+TEST_CASE("move", "[Test_ReaderPool]") {
+  // moving part way through a file carries on from the same place
+  BufferedFileReader bf(kLongFileName);
+  BufferedFileReader expected(kLongFileName);
+  for (int i = 0; i < 1000; i++) {
+    bf.get_token();
+    expected.get_token();
+  }
+  BufferedFileReader moved(std::move(bf));
+  REQUIRE_FALSE(bf.good());
+  REQUIRE(bf.tell() == -1);
+  REQUIRE(moved.tell() == expected.tell());
+  REQUIRE(moved.get_line() == expected.get_line());
+
+  // move assignment closes the file that was open
+  BufferedFileReader hello(kHelloFileName);
+  hello = std::move(moved);
+  REQUIRE(hello.get_token() == expected.get_token());
+
+  // the moved from reader can be opened again
+  bf.open_file(kHelloFileName);
+  REQUIRE(bf.get_token() == "Hello");
+
+  // readers can be kept in a vector, which moves them as it grows
+  vector<BufferedFileReader> readers;
+  for (int i = 0; i < 10; i++) {
+    readers.emplace_back(i % 2 == 0 ? kHelloFileName : kByeFileName);
+    readers.back().get_char();
+  }
+  for (int i = 0; i < 10; i++) {
+    REQUIRE(readers.at(i).tell() == 1);
+    REQUIRE(readers.at(i).get_char() == (i % 2 == 0 ? 'e' : 'o'));
+  }
+
+  SimpleFileReader sf(kHelloFileName);
+  sf.get_char();
+  SimpleFileReader moved_sf(std::move(sf));
+  REQUIRE_FALSE(sf.good());
+  REQUIRE(sf.tell() == -1);
+  REQUIRE(moved_sf.tell() == 1);
+  REQUIRE(moved_sf.get_char() == 'e');
+  SimpleFileReader other(kByeFileName);
+  other = std::move(moved_sf);
+  REQUIRE(other.get_char() == 'l');
+}
+
+TEST_CASE("ReaderPool", "[Test_ReaderPool]") {
+  ReaderPool pool(" \n", 2);
+  for (int i = 0; i < 100; i++) {
+    BufferedFileReader reader =
+        pool.acquire(i % 2 == 0 ? kHelloFileName : kLongFileName);
+    REQUIRE(reader.good());
+    if (i % 2 == 0) {
+      REQUIRE(reader.get_token() == "Hello");
+    } else {
+      REQUIRE(reader.get_token().has_value());
+    }
+    pool.release(std::move(reader));
+  }
+  REQUIRE(pool.num_created() == 1);
+  REQUIRE(pool.num_reused() == 99);
+  REQUIRE(pool.num_idle() == 1);
+
+  // no more than max_idle readers are kept
+  vector<BufferedFileReader> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.push_back(pool.acquire(kByeFileName));
+  }
+  REQUIRE(pool.num_created() == 4);
+  for (BufferedFileReader& reader : readers) {
+    pool.release(std::move(reader));
+  }
+  REQUIRE(pool.num_idle() == 2);
+
+  BufferedFileReader missing = pool.acquire("/tmp/does/not/exist");
+  REQUIRE_FALSE(missing.good());
+  REQUIRE_FALSE(missing.get_token().has_value());
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./ReverseLineReader.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+static constexpr const char* kGreatFileName = "./test_files/mutual_aid.txt";
+
+// helper functions
+
+// Reads every line with BufferedFileReader, front to back,
+// along with the offset each line starts at
+static void forward_lines(const char* fname,
+                          const string& delims,
+                          vector<vector<string>>* lines,
+                          vector<off_t>* offsets) {
+  BufferedFileReader bf(fname, delims);
+  off_t offset = bf.tell();
+  optional<vector<string>> opt = bf.get_line();
+  while (opt.has_value()) {
+    // get_line() returns an extra empty line when it runs into the EOF
+    if (!bf.good() && bf.tell() == offset) {
+      break;
+    }
+    lines->push_back(opt.value());
+    offsets->push_back(offset);
+    offset = bf.tell();
+    opt = bf.get_line();
+  }
+}
+
+static void check_reverse(const char* fname, const string& delims) {
+  vector<vector<string>> lines;
+  vector<off_t> offsets;
+  forward_lines(fname, delims, &lines, &offsets);
+  REQUIRE(lines.size() > 0);
+
+  ReverseLineReader rf(fname, delims);
+  for (size_t i = lines.size(); i > 0; i--) {
+    REQUIRE(rf.good());
+    optional<vector<string>> opt = rf.get_line();
+    REQUIRE(opt.has_value());
+    REQUIRE(opt.value() == lines.at(i - 1));
+    REQUIRE(rf.tell() == offsets.at(i - 1));
+  }
+  REQUIRE_FALSE(rf.good());
+  REQUIRE_FALSE(rf.get_line().has_value());
+  REQUIRE(rf.tell() == 0);
+}
+
+TEST_CASE("Basic", "[Test_ReverseLineReader]") {
+  // no '\n' at the end of the file
+  ReverseLineReader rf(kHelloFileName);
+  REQUIRE(rf.good());
+  optional<string_view> raw = rf.get_raw_line();
+  REQUIRE(raw.has_value());
+  REQUIRE(raw.value() == "Hello World!");
+  REQUIRE_FALSE(rf.good());
+  REQUIRE_FALSE(rf.get_raw_line().has_value());
+
+  ReverseLineReader missing("./test_files/does_not_exist.txt");
+  REQUIRE_FALSE(missing.good());
+  REQUIRE(missing.tell() == -1);
+  REQUIRE_FALSE(missing.get_line().has_value());
+}
+
+TEST_CASE("get_line", "[Test_ReverseLineReader]") {
+  check_reverse(kByeFileName, ",\t ");
+  check_reverse(kGreatFileName, ",\t ");
+  check_reverse(kLongFileName, "\r\n\t ");
+}
+
+TEST_CASE("blank_lines", "[Test_ReverseLineReader]") {
+  // lines longer than a chunk, and runs of empty lines
+  string contents = "\n\nfirst line\n" + string(200000, 'x') + " y\n\n\n" +
+                    string(70000, 'z') + "\nlast\n";
+  char fname[] = "/tmp/reverse_readerXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  REQUIRE(write(fd, contents.data(), contents.length()) ==
+          static_cast<ssize_t>(contents.length()));
+  close(fd);
+
+  check_reverse(fname, " ");
+  unlink(fname);
+}
+
+TEST_CASE("last_line", "[Test_ReverseLineReader]") {
+  // with no '\n' at the end, the last token of the last line is kept,
+  // where BufferedFileReader::get_line() drops it
+  char fname[] = "/tmp/reverse_readerXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  REQUIRE(write(fd, "a b\nc d", 7) == 7);
+  close(fd);
+  ReverseLineReader rf(fname, " ");
+  REQUIRE(rf.get_line() == vector<string>{"c", "d"});
+  REQUIRE(rf.get_line() == vector<string>{"a", "b"});
+  REQUIRE_FALSE(rf.get_line().has_value());
+  BufferedFileReader bf(fname, " ");
+  REQUIRE(bf.get_line() == vector<string>{"a", "b"});
+  REQUIRE(bf.get_line() == vector<string>{"c"});
+
+  // one line many chunks long
+  string line;
+  for (int i = 0; line.length() < 3000000; i++) {
+    line += to_string(i) + ' ';
+  }
+  fd = open(fname, O_WRONLY | O_TRUNC);
+  string contents = "first\n" + line + "\nlast";
+  REQUIRE(write(fd, contents.data(), contents.length()) ==
+          static_cast<ssize_t>(contents.length()));
+  close(fd);
+  ReverseLineReader long_line(fname, " ");
+  REQUIRE(long_line.get_raw_line() == "last");
+  REQUIRE(long_line.get_raw_line() == line);
+  REQUIRE(long_line.tell() == 6);
+  REQUIRE(long_line.get_raw_line() == "first");
+  REQUIRE_FALSE(long_line.good());
+  unlink(fname);
+}
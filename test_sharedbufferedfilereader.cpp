@@ -0,0 +1,119 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./SharedBufferedFileReader.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+static constexpr int kThreads = 4;
+
+TEST_CASE("Basic", "[Test_SharedBufferedFileReader]") {
+  // one thread reads the same tokens as BufferedFileReader
+  SharedBufferedFileReader shared(kLongFileName);
+  BufferedFileReader bf(kLongFileName);
+  REQUIRE(shared.advise(AccessPattern::kSequential));
+  REQUIRE(shared.good());
+  REQUIRE(shared.tell() == 0);
+  for (optional<string> token = bf.get_token(); token.has_value();
+       token = bf.get_token()) {
+    REQUIRE(shared.get_token() == token);
+  }
+  REQUIRE_FALSE(shared.get_token().has_value());
+  REQUIRE_FALSE(shared.good());
+  REQUIRE(shared.tell() == bf.tell());
+
+  SharedBufferedFileReader lines(kHelloFileName, " ");
+  REQUIRE(lines.get_line() == vector<string>{"Hello", "World!"});
+  REQUIRE_FALSE(lines.get_line().has_value());
+
+  // an empty file is read rather than mapped
+  char fname[] = "/tmp/sharedXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  close(fd);
+  SharedBufferedFileReader empty(fname);
+  REQUIRE_FALSE(empty.good());
+  REQUIRE(empty.tell() == 0);
+  REQUIRE_FALSE(empty.get_token_view().has_value());
+  REQUIRE_FALSE(empty.advise(AccessPattern::kSequential));
+  unlink(fname);
+
+  SharedBufferedFileReader missing("/tmp/does/not/exist");
+  REQUIRE_FALSE(missing.good());
+  REQUIRE(missing.tell() == -1);
+  REQUIRE_FALSE(missing.get_line().has_value());
+}
+
+TEST_CASE("threads", "[Test_SharedBufferedFileReader]") {
+  vector<string> expected;
+  BufferedFileReader bf(kLongFileName);
+  for (optional<string> token = bf.get_token(); token.has_value();
+       token = bf.get_token()) {
+    expected.push_back(token.value());
+  }
+
+  // every token goes to exactly one thread, whole
+  SharedBufferedFileReader shared(kLongFileName);
+  vector<vector<string>> tokens(kThreads);
+  vector<thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&shared, &tokens, t]() {
+      for (optional<string_view> token = shared.get_token_view();
+           token.has_value(); token = shared.get_token_view()) {
+        tokens[t].emplace_back(token.value());
+      }
+    });
+  }
+  for (thread& thread : threads) {
+    thread.join();
+  }
+  vector<string> all;
+  for (const vector<string>& thread_tokens : tokens) {
+    all.insert(all.end(), thread_tokens.begin(), thread_tokens.end());
+  }
+  sort(all.begin(), all.end());
+  sort(expected.begin(), expected.end());
+  REQUIRE(all == expected);
+
+  // the same for lines, mixed with tokens
+  SharedBufferedFileReader mixed(kLongFileName, " ");
+  vector<size_t> num_lines(kThreads);
+  threads.clear();
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&mixed, &num_lines, t]() {
+      while (mixed.good()) {
+        if (t == 0) {
+          mixed.get_token();
+        } else if (mixed.get_line().has_value()) {
+          num_lines[t]++;
+        }
+      }
+    });
+  }
+  for (thread& thread : threads) {
+    thread.join();
+  }
+  REQUIRE_FALSE(mixed.get_line().has_value());
+  REQUIRE(mixed.tell() == bf.tell());
+}
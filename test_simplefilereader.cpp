@@ -1,9 +1,14 @@
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/select.h>
 #include <unistd.h>
+#include <array>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <span>
 #include <string>
+#include <thread>
 #include "./SimpleFileReader.hpp"
 #include "catch.hpp"
 
@@ -361,3 +366,171 @@ TEST_CASE("Complex", "[Test_SimpleFileReader]") {
   REQUIRE_FALSE(sf.good());
   REQUIRE(static_cast<size_t>(sf.tell()) == kGreatContents.length());
 }
+
+TEST_CASE("non_seekable", "[Test_SimpleFileReader]") {
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  string contents;
+  for (int i = 0; i < 20000; i++) {
+    contents += static_cast<char>('a' + i % 26);
+  }
+  bool wrote = true;
+  thread writer([fd = fds[1], &contents, &wrote]() {
+    for (size_t i = 0; i < contents.length(); i += 3000) {
+      string piece = contents.substr(i, 3000);
+      wrote = wrote && write(fd, piece.data(), piece.length()) ==
+                           static_cast<ssize_t>(piece.length());
+    }
+    close(fd);
+  });
+
+  SimpleFileReader sf(fds[0]);
+  REQUIRE(sf.good());
+  REQUIRE_FALSE(sf.seekable());
+  REQUIRE(sf.tell() == 0);
+  REQUIRE('a' == sf.get_char());
+  REQUIRE(sf.tell() == 1);
+
+  // a request bigger than a single write still gets all of it
+  optional<string> opt = sf.get_chars(10000);
+  REQUIRE(opt.has_value());
+  REQUIRE(opt.value() == contents.substr(1, 10000));
+  REQUIRE(sf.tell() == 10001);
+  opt = sf.get_chars(20000);
+  REQUIRE(opt.has_value());
+  REQUIRE(opt.value() == contents.substr(10001));
+  REQUIRE_FALSE(sf.good());
+  REQUIRE(static_cast<size_t>(sf.tell()) == contents.length());
+  REQUIRE_FALSE(sf.rewind());
+  writer.join();
+  REQUIRE(wrote);
+
+  // a regular file given by its descriptor can still rewind
+  SimpleFileReader from_fd(open(kHelloFileName, O_RDONLY));
+  REQUIRE(from_fd.seekable());
+  REQUIRE('H' == from_fd.get_char());
+  REQUIRE(from_fd.rewind());
+  REQUIRE(from_fd.tell() == 0);
+  REQUIRE('H' == from_fd.get_char());
+
+  SimpleFileReader bad(-1);
+  REQUIRE_FALSE(bad.good());
+  REQUIRE_FALSE(bad.seekable());
+  REQUIRE(bad.tell() == -1);
+}
+
+TEST_CASE("large_file", "[Test_SimpleFileReader]") {
+  // a sparse file just over 5 GiB, with a few bytes past 4 GiB
+  constexpr off_t kGiB = off_t{1} << 30;
+  constexpr off_t kSize = 5 * kGiB + 123;
+  constexpr off_t kMarker = 4 * kGiB + 1000;
+  char fname[] = "/tmp/large_fileXXXXXX";
+  int fd = mkstemp(fname);
+  REQUIRE(fd >= 0);
+  REQUIRE(ftruncate(fd, kSize) == 0);
+  string marker = "past four";
+  REQUIRE(pwrite(fd, marker.data(), marker.length(), kMarker) ==
+          static_cast<ssize_t>(marker.length()));
+
+  // start reading part way through by handing over the descriptor
+  REQUIRE(lseek(fd, kMarker, SEEK_SET) == kMarker);
+  SimpleFileReader sf(fd);
+  REQUIRE(sf.tell() == kMarker);
+  REQUIRE('p' == sf.get_char());
+  REQUIRE(sf.tell() == kMarker + 1);
+  optional<string> opt = sf.get_chars(marker.length() - 1);
+  REQUIRE(opt.value() == marker.substr(1));
+  REQUIRE(sf.tell() == kMarker + static_cast<off_t>(marker.length()));
+
+  // up to the end of the file
+  int end_fd = open(fname, O_RDONLY);
+  REQUIRE(lseek(end_fd, kSize - 10, SEEK_SET) == kSize - 10);
+  SimpleFileReader end(end_fd);
+  opt = end.get_chars(100);
+  REQUIRE(opt.value() == string(10, '\0'));
+  REQUIRE_FALSE(end.good());
+  REQUIRE(end.tell() == kSize);
+  REQUIRE(end.rewind());
+  REQUIRE(end.tell() == 0);
+  unlink(fname);
+}
+
+TEST_CASE("scatter_gather", "[Test_SimpleFileReader]") {
+  // fixed layout records: a 4 byte header, a 10 byte body and a
+  // 2 byte trailer
+  ifstream file(kLongFileName);
+  string contents((istreambuf_iterator<char>(file)),
+                  istreambuf_iterator<char>());
+  SimpleFileReader sf(kLongFileName);
+  char header[4];
+  char body[10];
+  char trailer[2];
+  array<span<char>, 3> record{span<char>(header), span<char>(body),
+                              span<char>(trailer)};
+  size_t offset = 0;
+  for (int i = 0; i < 1000; i++) {
+    REQUIRE(sf.read_into(record) == 16);
+    REQUIRE(string(header, 4) == contents.substr(offset, 4));
+    REQUIRE(string(body, 10) == contents.substr(offset + 4, 10));
+    REQUIRE(string(trailer, 2) == contents.substr(offset + 14, 2));
+    offset += 16;
+    REQUIRE(sf.tell() == static_cast<off_t>(offset));
+  }
+  REQUIRE(sf.good());
+
+  // reading at an offset doesn't move the reader
+  REQUIRE(sf.pread_into(record, 5) == 16);
+  REQUIRE(string(header, 4) == contents.substr(5, 4));
+  REQUIRE(string(trailer, 2) == contents.substr(19, 2));
+  REQUIRE(sf.tell() == static_cast<off_t>(offset));
+  REQUIRE(sf.get_char() == contents[offset]);
+
+  // more parts than fit in one call, some of them empty
+  string big(200000, '\0');
+  vector<span<char>> parts;
+  for (size_t start = 0; start < big.length(); start += 1000) {
+    parts.emplace_back(big.data() + start, 1000);
+    parts.emplace_back(big.data() + start, 0);
+  }
+  REQUIRE(sf.rewind());
+  REQUIRE(sf.read_into(parts) == 200000);
+  REQUIRE(big == contents.substr(0, 200000));
+
+  // the file ends part way through a record
+  off_t near_end = contents.length() - 7;
+  REQUIRE(sf.pread_into(record, near_end) == 7);
+  REQUIRE(string(header, 4) == contents.substr(near_end, 4));
+  REQUIRE(string(body, 3) == contents.substr(near_end + 4));
+  REQUIRE(sf.pread_into(record, contents.length()) == 0);
+  REQUIRE(sf.good());
+  string rest(contents.length() - 200000 + 5, '\0');
+  array<span<char>, 1> all{span<char>(rest)};
+  REQUIRE(sf.read_into(all) ==
+          static_cast<ssize_t>(contents.length() - 200000));
+  REQUIRE_FALSE(sf.good());
+  REQUIRE(sf.read_into(record) == 0);
+
+  // a pipe, written in pieces that don't line up with the parts
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  bool wrote = true;
+  thread writer([fd = fds[1], &contents, &wrote]() {
+    for (size_t i = 0; i < 48; i += 5) {
+      wrote = wrote && write(fd, contents.data() + i, 5) == 5;
+      this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    close(fd);
+  });
+  SimpleFileReader from_pipe(fds[0]);
+  for (size_t start = 0; start < 48; start += 16) {
+    REQUIRE(from_pipe.read_into(record) == 16);
+    REQUIRE(string(body, 10) == contents.substr(start + 4, 10));
+  }
+  REQUIRE(from_pipe.pread_into(record, 0) == -1);
+  writer.join();
+  REQUIRE(wrote);
+
+  SimpleFileReader bad(-1);
+  REQUIRE(bad.read_into(record) == -1);
+  REQUIRE(bad.pread_into(record, 0) == -1);
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright ©2024 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./BufferedFileReader.hpp"
+#include "./LineBatch.hpp"
+#include "./SpscRing.hpp"
+#include "./TokenPipeline.hpp"
+#include "./catch.hpp"
+
+using namespace std;
+
+static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+TEST_CASE("SpscRing", "[Test_TokenPipeline]") {
+  SpscRing<int> ring(3);
+  REQUIRE(ring.capacity() == 4);
+  REQUIRE(ring.try_front() == nullptr);
+
+  // fill it up without another thread
+  for (int i = 0; i < 4; i++) {
+    int* slot = ring.try_claim();
+    REQUIRE(slot != nullptr);
+    *slot = i;
+    ring.publish();
+  }
+  REQUIRE(ring.try_claim() == nullptr);
+  REQUIRE(ring.size() == 4);
+  REQUIRE(*ring.try_front() == 0);
+  ring.pop();
+  REQUIRE(ring.try_claim() != nullptr);
+  for (int i = 1; i < 4; i++) {
+    REQUIRE(*ring.front() == i);
+    ring.pop();
+  }
+
+  // a producer thread, which has to wait on the consumer
+  constexpr int kCount = 100000;
+  thread producer([&ring]() {
+    for (int i = 0; i < kCount; i++) {
+      int* slot = ring.claim();
+      *slot = i;
+      ring.publish();
+    }
+    ring.close();
+  });
+  // (catch assertions are not thread safe, so only the consumer checks)
+  int expected = 0;
+  bool in_order = true;
+  for (int* slot = ring.front(); slot != nullptr; slot = ring.front()) {
+    in_order = in_order && *slot == expected;
+    expected++;
+    ring.pop();
+  }
+  producer.join();
+  REQUIRE(in_order);
+  REQUIRE(expected == kCount);
+
+  // the consumer giving up wakes a waiting producer
+  SpscRing<int> cancelled(1);
+  bool claimed_after_cancel = true;
+  thread blocked([&cancelled, &claimed_after_cancel]() {
+    cancelled.claim();
+    cancelled.publish();
+    claimed_after_cancel = cancelled.claim() != nullptr;
+  });
+  REQUIRE(cancelled.front() != nullptr);
+  cancelled.cancel();
+  blocked.join();
+  REQUIRE_FALSE(claimed_after_cancel);
+}
+
+TEST_CASE("TokenPipeline", "[Test_TokenPipeline]") {
+  // the same lines as reading the batches directly
+  BufferedFileReader bf(kLongFileName);
+  LineBatch expected;
+  TokenPipeline pipeline(kLongFileName, "\r\n\t ", 4, 100);
+  REQUIRE(pipeline.good());
+  size_t num_lines = 0;
+  size_t num_batches = 0;
+  for (const LineBatch* batch = pipeline.next(); batch != nullptr;
+       batch = pipeline.next()) {
+    REQUIRE(expected.read(bf, 100, 1 << 20) == batch->num_lines());
+    REQUIRE(batch->arena() == expected.arena());
+    REQUIRE(batch->token_lengths() == expected.token_lengths());
+    REQUIRE(batch->line_starts() == expected.line_starts());
+    num_lines += batch->num_lines();
+    num_batches++;
+  }
+  REQUIRE(expected.read(bf, 100, 1 << 20) == 0);
+  REQUIRE(pipeline.next() == nullptr);
+
+  TokenPipeline::Stats stats = pipeline.stats();
+  REQUIRE(stats.lines == num_lines);
+  REQUIRE(stats.batches == num_batches);
+  REQUIRE(stats.max_depth <= 4);
+
+  TokenPipeline missing("/tmp/does/not/exist");
+  REQUIRE_FALSE(missing.good());
+  REQUIRE(missing.next() == nullptr);
+}
+
+TEST_CASE("backpressure", "[Test_TokenPipeline]") {
+  // a slow consumer makes the producer wait for room
+  TokenPipeline pipeline(kLongFileName, "\r\n\t ", 2, 1000);
+  for (int i = 0; i < 10; i++) {
+    REQUIRE(pipeline.next() != nullptr);
+    this_thread::sleep_for(chrono::milliseconds(5));
+  }
+  TokenPipeline::Stats stats = pipeline.stats();
+  REQUIRE(stats.producer_stalls > 0);
+  REQUIRE(stats.producer_wait_ns > 0);
+  REQUIRE(stats.max_depth <= 2);
+  REQUIRE(stats.batches <= 10 + 2);
+  // destroyed before the end of the file, with the producer waiting
+}